@@ -44,6 +44,18 @@
 //#define INCLUDE_ENCODERS                    //{"Name":"INCLUDE_ENCODERS","Type":"autodefine","Condition":"[ENABLED_ENCODERS_COUNT]>0"}
 //#define INCLUDE_BUTTONS                     //{"Name":"INCLUDE_BUTTONS","Type":"autodefine","Condition":"[ENABLED_BUTTONS_COUNT]>0"}
 //#define INCLUDE_BUTTONMATRIX                //{"Name":"INCLUDE_BUTTONMATRIX","Type":"autodefine","Condition":"[ENABLED_BUTTONMATRIX]>0"}
+//#define INCLUDE_74HC165                     //{"Name":"INCLUDE_74HC165","Type":"autodefine","Condition":"[ENABLED_74HC165_CHIPS]>0"}
+//#define INCLUDE_ANALOGAXES                  //{"Name":"INCLUDE_ANALOGAXES","Type":"autodefine","Condition":"[ANALOGAXES_COUNT]>0"}
+
+// I2C writes queued by the displays and the Adafruit motor shield, sent from idle() and loop()
+#if defined(INCLUDE_OLED) || defined(INCLUDE_I2CLCD) || defined(INCLUDE_LEDBACKPACK) || defined(INCLUDE_HT16K33_SINGLECOLORMATRIX) || defined(INCLUDE_SHAKEITADASHIELD)
+#define INCLUDE_I2CQUEUE
+#endif
+
+// Haptic effects synthesized for the shakeit motors
+#if defined(INCLUDE_SHAKEITADASHIELD) || defined(INCLUDE_SHAKEITDKSHIELD) || defined(INCLUDE_SHAKEITL298N) || defined(INCLUDE_SHAKEITMOTOMONSTER) || defined(INCLUDE_SHAKEITPWM)
+#define INCLUDE_HAPTICS
+#endif
 
 #include <avr/pgmspace.h>
 #include <EEPROM.h>
@@ -53,15 +65,16 @@
 #include <Wire.h>
 #include "Adafruit_GFX.h"
 #include "FlowSerialRead.h"
+#include "SHInputEvents.h"
 #include "setPwmFrequency.h"
 #include "SHDebouncer.h"
-#include "SHButton.h"
 
 // ----------------------------------------------------- HW SETTINGS, PLEASE REVIEW ALL -------------------------------------------
 #define DEVICE_NAME "SimHub Dash" //{"Group":"General","Name":"DEVICE_NAME","Title":"Device name,\r\n make sure to use a unique name when using multiple arduinos","DefaultValue":"SimHub Dash","Type":"string","Template":"#define DEVICE_NAME \"{0}\""}
 
 #define ENABLE_MICRO_GAMEPAD 0           //{"Group":"GAMEPAD","Name":"ENABLE_MICRO_GAMEPAD","Title":"Enable arduino micro gamepad output for all the activated buttons/encoders","DefaultValue":"0","Type":"bool"}
 #define MICRO_GAMEPAD_ENCODERPRESSTIME 50 //{"Name":"MICRO_GAMEPAD_ENCODERPRESSTIME","Title":"Define how long (in milliseconds) the encoder related button will be hold after an encoder movement","DefaultValue":"50","Type":"int","Condition":"ENABLE_MICRO_GAMEPAD>0","Max":100}
+#define GAMEPAD_REPORT_INTERVAL_US 1000 //{"Name":"GAMEPAD_REPORT_INTERVAL_US","Title":"Minimum time (in microseconds) between two gamepad reports, changes within this time are sent together","DefaultValue":"1000","Type":"int","Condition":"ENABLE_MICRO_GAMEPAD>0","Min":1000,"Max":20000}
 
 // -------------------------------------------------------------------------------------------------------
 // TM1638 Modules ----------------------------------------------------------------------------------------
@@ -125,7 +138,7 @@
 #define MAX7221_DATA 3           //{"Name":"MAX7221_DATA","Title":"DATA (DIN) digital pin number","DefaultValue":"3","Type":"pin;MAX7221 7seg. DATA","Condition":"MAX7221_ENABLEDMODULES > 0"}
 #define MAX7221_CLK 5            //{"Name":"MAX7221_CLK","Title":"CLOCK (CLK) digital pin number","DefaultValue":"5","Type":"pin;MAX7221 7seg. CLK","Condition":"MAX7221_ENABLEDMODULES > 0"}
 #define MAX7221_LOAD 4           //{"Name":"MAX7221_LOAD","Title":"LOAD (LD) digital pin number","DefaultValue":"4","Type":"pin;MAX7221 7seg. LOAD/LD","Condition":"MAX7221_ENABLEDMODULES > 0"}
-SHMAX72217Segment shMAX72217Segment;
+SHMAX72217Segment<MAX7221_DATA, MAX7221_CLK, MAX7221_LOAD> shMAX72217Segment;
 #endif // INCLUDE_MAX7221_MODULES
 
 // -------------------------------------------------------------------------------------------------------
@@ -138,7 +151,7 @@ SHMAX72217Segment shMAX72217Segment;
 #define MAX7221_MATRIX_DATA 3    //{"Name":"MAX7221_MATRIX_DATA","Title":"DATA (DIN) digital pin number","DefaultValue":"3","Type":"pin;MAX7221 Matrix DATA","Condition":"MAX7221_MATRIX_ENABLED>0"}
 #define MAX7221_MATRIX_CLK 5     //{"Name":"MAX7221_MATRIX_CLK","Title":"CLOCK (CLK) digital pin number","DefaultValue":"5","Type":"pin;MAX7221 Matrix CLK","Condition":"MAX7221_MATRIX_ENABLED>0"}
 #define MAX7221_MATRIX_LOAD 4    //{"Name":"MAX7221_MATRIX_LOAD","Title":"LOAD (LD/CS) digital pin number","DefaultValue":"4","Type":"pin;MAX7221 Matrix LOAD/LD","Condition":"MAX7221_MATRIX_ENABLED>0"}
-SHMatrixMAX7219 shMatrixMAX7219;
+SHMatrixMAX7219<MAX7221_MATRIX_DATA, MAX7221_MATRIX_CLK, MAX7221_MATRIX_LOAD> shMatrixMAX7219;
 #endif
 
 
@@ -299,7 +312,8 @@ Adafruit_7segment ADA_HT16K33_7SEGMENTS = Adafruit_7segment();
 #include "Adafruit_LEDBackpack.h"
 #define ADA_HT16K33_BICOLORMATRIX_I2CADDRESS 0x70 //{"Name":"ADA_HT16K33_BICOLORMATRIX_I2CADDRESS","Title":"Adafruit HT16K33 Bicolor matrix matrix I2C address","DefaultValue":"0x70","Type":"hex","Condition":"ENABLE_ADA_HT16K33_SingleColorMatrix>0"}
 Adafruit_BicolorMatrix ADA_HT16K33_MATRIX = Adafruit_BicolorMatrix();
-byte ADA_HT16K33_Matrix_luminosity = 0;
+// Brightness set by begin()
+byte ADA_HT16K33_Matrix_luminosity = 15;
 #endif
 
 
@@ -367,6 +381,9 @@ SHPWMPin shCONSPIN(CONS_PIN);
 // https://github.com/zegreatclan/SimHub/wiki/Arduino-Press-Buttons
 // ----------------------------------------------------------------------------------------------------------
 #define ENABLED_BUTTONS_COUNT 0 //{"Group":"Additional Buttons","Name":"ENABLED_BUTTONS_COUNT","Title":"Additional buttons (directly connected to the arduino, 12 max) buttons count","DefaultValue":"0","Type":"int","Max":12}
+#define DEBOUNCE_SAMPLE_US 1000 //{"Name":"DEBOUNCE_SAMPLE_US","Title":"Buttons debounce sample period (microseconds), also used for the encoders buttons","DefaultValue":"1000","Type":"int","Min":100,"Max":10000}
+#define DEBOUNCE_SAMPLES 4      //{"Name":"DEBOUNCE_SAMPLES","Title":"Identical samples needed to accept a button change","DefaultValue":"4","Type":"int","Min":1,"Max":8}
+#include "SHButton.h"
 #ifdef  INCLUDE_BUTTONS
 
 #define BUTTON_PIN_1 3          //{"Name":"BUTTON_PIN_1","Title":"1'st Additional button digital pin","DefaultValue":"3","Type":"pin;Button 1","Condition":"ENABLED_BUTTONS_COUNT>=1"}
@@ -396,8 +413,9 @@ SHDebouncer ButtonsDebouncer(10);
 // ----------------------------------------------------------------------------------------------------------
 #define ENABLED_ENCODERS_COUNT 0     //{"Group":"Rotary Encoders","Name":"ENABLED_ENCODERS_COUNT","Title":"Rotary encoders enabled","DefaultValue":"0","Type":"int","Max":8}
 #ifdef  INCLUDE_ENCODERS
-#include "SHRotaryEncoder.h"
-
+#define ENCODERS_ENABLE_INTERRUPTS 1 //{"Name":"ENCODERS_ENABLE_INTERRUPTS","Title":"Decode encoders in pin change interrupts when both outputs support it\r\nDisable if another library uses the pin change interrupts","DefaultValue":"1","Type":"bool","Condition":"ENABLED_ENCODERS_COUNT>0"}
+#define ENCODERS_ACCEL_MAX 8         //{"Name":"ENCODERS_ACCEL_MAX","Title":"Steps counted for a detent when the encoder is spun fast (1 disables the acceleration)\r\nOnly used when the host asks for accelerated deltas","DefaultValue":"8","Type":"int","Condition":"ENABLED_ENCODERS_COUNT>0","Min":1,"Max":32}
+#define ENCODERS_REPORT_MS 20        //{"Name":"ENCODERS_REPORT_MS","Title":"Minimum time (in milliseconds) between two accelerated deltas of an encoder","DefaultValue":"20","Type":"int","Condition":"ENABLED_ENCODERS_COUNT>0","Min":5,"Max":100}
 #define ENCODER1_CLK_PIN 7           //{"Name":"ENCODER1_CLK_PIN","Title":"Encoder 1 output A (CLK) pin","DefaultValue":"7","Type":"pin;Encoder 1 CLK","Condition":"ENABLED_ENCODERS_COUNT>0"}
 #define ENCODER1_DT_PIN 8            //{"Name":"ENCODER1_DT_PIN","Title":"Encoder 1 output B (DT) pin","DefaultValue":"8","Type":"pin;Encoder 1 DT","Condition":"ENABLED_ENCODERS_COUNT>0"}
 #define ENCODER1_BUTTON_PIN 9        //{"Name":"ENCODER1_BUTTON_PIN","Title":"Encoder 1 button (SW) pin","DefaultValue":"9","Type":"pin;Encoder 1 SWITCH","Condition":"ENABLED_ENCODERS_COUNT>0","Min":-1}
@@ -454,6 +472,18 @@ SHDebouncer ButtonsDebouncer(10);
 #define ENCODER8_REVERSE_DIRECTION 0 //{"Name":"ENCODER8_REVERSE_DIRECTION","Title":"Encoder 8 reverse direction","DefaultValue":"0","Type":"bool","Condition":"ENABLED_ENCODERS_COUNT>7"}
 #define ENCODER8_ENABLE_HALFSTEPS 0  //{"Name":"ENCODER8_ENABLE_HALFSTEPS","Title":"Encoder 8 steps mode","DefaultValue":"0","Type":"list","Condition":"ENABLED_ENCODERS_COUNT>=8","ListValues":"0,Full steps;1,Half steps"}
 
+// Pin change vectors used by the enabled encoders
+#define ENCODERS_PCINT_VECTORS ( \
+	(ENABLED_ENCODERS_COUNT > 0 ? ENCODERS_PCINT_VECTOR(ENCODER1_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER1_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 1 ? ENCODERS_PCINT_VECTOR(ENCODER2_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER2_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 2 ? ENCODERS_PCINT_VECTOR(ENCODER3_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER3_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 3 ? ENCODERS_PCINT_VECTOR(ENCODER4_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER4_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 4 ? ENCODERS_PCINT_VECTOR(ENCODER5_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER5_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 5 ? ENCODERS_PCINT_VECTOR(ENCODER6_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER6_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 6 ? ENCODERS_PCINT_VECTOR(ENCODER7_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER7_DT_PIN) : 0) | \
+	(ENABLED_ENCODERS_COUNT > 7 ? ENCODERS_PCINT_VECTOR(ENCODER8_CLK_PIN) | ENCODERS_PCINT_VECTOR(ENCODER8_DT_PIN) : 0))
+#include "SHRotaryEncoder.h"
+
 SHRotaryEncoder encoder1, encoder2, encoder3, encoder4, encoder5, encoder6, encoder7, encoder8;
 SHRotaryEncoder * SHRotaryEncoders[] = { &encoder1, &encoder2, &encoder3, &encoder4, &encoder5, &encoder6, &encoder7, &encoder8 };
 #endif
@@ -467,6 +497,7 @@ SHRotaryEncoder * SHRotaryEncoders[] = { &encoder1, &encoder2, &encoder3, &encod
 
 #define BMATRIX_COLS 3         //{"Name":"BMATRIX_COLS","Title":"Columns","DefaultValue":"3","Type":"int","Condition":"ENABLED_BUTTONMATRIX>0","Min":2,"Max":8}
 #define BMATRIX_ROWS 3         //{"Name":"BMATRIX_ROWS","Title":"Rows","DefaultValue":"3","Type":"int","Condition":"ENABLED_BUTTONMATRIX>0","Min":2,"Max":8}
+#define BMATRIX_GHOSTDETECTION 1 //{"Name":"BMATRIX_GHOSTDETECTION","Title":"Ignore ambiguous key combinations\r\nCan be disabled when every key has a diode","DefaultValue":"1","Type":"bool","Condition":"ENABLED_BUTTONMATRIX>0"}
 
 #ifdef  INCLUDE_BUTTONMATRIX
 #include "SHButtonMatrix.h"
@@ -495,6 +526,53 @@ SHButtonMatrix shButtonMatrix;
 
 #endif
 
+// ----------------------- 74HC165 SHIFT REGISTERS BUTTONS --------------------------------------------------
+// Chained 74HC165 parallel in shift registers, 8 buttons per chip, read with hardware SPI
+// QH of the first chip to MISO (12 on uno), CLK to SCK (13 on uno), CLK INH to ground
+// ----------------------------------------------------------------------------------------------------------
+#define ENABLED_74HC165_CHIPS 0  //{"Group":"74HC165 Shift registers buttons","Name":"ENABLED_74HC165_CHIPS","Title":"Chained 74HC165 count (8 buttons each)\r\nQH to MISO and CLK to SCK (12 and 13 on uno), CLK INH to ground","DefaultValue":"0","Type":"int","Max":8}
+#define SR165_LOAD_PIN 9         //{"Name":"SR165_LOAD_PIN","Title":"SH/LD digital pin number","DefaultValue":"9","Type":"pin;74HC165 SH/LD","Condition":"ENABLED_74HC165_CHIPS>0"}
+#define SR165_ACTIVE_LOW 1       //{"Name":"SR165_ACTIVE_LOW","Title":"Buttons connect the inputs to ground (inputs with pull up resistors)","DefaultValue":"1","Type":"bool","Condition":"ENABLED_74HC165_CHIPS>0"}
+#ifdef INCLUDE_74HC165
+#include "SH74HC165.h"
+SH74HC165<SR165_LOAD_PIN> sh74HC165;
+#endif
+
+// ----------------------- ANALOG AXES ----------------------------------------------------------------------
+// Pedals and handbrake : potentiometers or load cell amplifiers on the analog inputs,
+// sent as gamepad axes X, Y, Z, Rx, Ry, Rz
+// ----------------------------------------------------------------------------------------------------------
+#define ANALOGAXES_COUNT 0               //{"Group":"Analog axes","Name":"ANALOGAXES_COUNT","Title":"Analog axes (pedals, handbrake) count","DefaultValue":"0","Type":"int","Max":6}
+#define ANALOGAXES_OVERSAMPLING_BITS 1   //{"Name":"ANALOGAXES_OVERSAMPLING_BITS","Title":"Extra resolution bits from oversampling\r\nEach bit divides the axes update rate by 4 (1kHz for 4 axes with 1 bit)","DefaultValue":"1","Type":"int","Condition":"ANALOGAXES_COUNT>0","Min":0,"Max":3}
+#define ANALOGAXES_DEADZONE_LOW 2        //{"Name":"ANALOGAXES_DEADZONE_LOW","Title":"Deadzone at the start of the travel (percent)","DefaultValue":"2","Type":"int","Condition":"ANALOGAXES_COUNT>0","Min":0,"Max":50}
+#define ANALOGAXES_DEADZONE_HIGH 2       //{"Name":"ANALOGAXES_DEADZONE_HIGH","Title":"Deadzone at the end of the travel (percent)","DefaultValue":"2","Type":"int","Condition":"ANALOGAXES_COUNT>0","Min":0,"Max":50}
+#ifdef INCLUDE_ANALOGAXES
+#define ANALOGAXIS1_INPUT 0          //{"Name":"ANALOGAXIS1_INPUT","Title":"1st axis analog input (0 for A0)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=1","Max":11}
+#define ANALOGAXIS1_MIN 0            //{"Name":"ANALOGAXIS1_MIN","Title":"1st axis released value (0-1023)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=1","Max":1023}
+#define ANALOGAXIS1_MAX 1023         //{"Name":"ANALOGAXIS1_MAX","Title":"1st axis fully pressed value (0-1023)","DefaultValue":"1023","Type":"int","Condition":"ANALOGAXES_COUNT>=1","Max":1023}
+
+#define ANALOGAXIS2_INPUT 1          //{"Name":"ANALOGAXIS2_INPUT","Title":"2nd axis analog input (0 for A0)","DefaultValue":"1","Type":"int","Condition":"ANALOGAXES_COUNT>=2","Max":11}
+#define ANALOGAXIS2_MIN 0            //{"Name":"ANALOGAXIS2_MIN","Title":"2nd axis released value (0-1023)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=2","Max":1023}
+#define ANALOGAXIS2_MAX 1023         //{"Name":"ANALOGAXIS2_MAX","Title":"2nd axis fully pressed value (0-1023)","DefaultValue":"1023","Type":"int","Condition":"ANALOGAXES_COUNT>=2","Max":1023}
+
+#define ANALOGAXIS3_INPUT 2          //{"Name":"ANALOGAXIS3_INPUT","Title":"3rd axis analog input (0 for A0)","DefaultValue":"2","Type":"int","Condition":"ANALOGAXES_COUNT>=3","Max":11}
+#define ANALOGAXIS3_MIN 0            //{"Name":"ANALOGAXIS3_MIN","Title":"3rd axis released value (0-1023)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=3","Max":1023}
+#define ANALOGAXIS3_MAX 1023         //{"Name":"ANALOGAXIS3_MAX","Title":"3rd axis fully pressed value (0-1023)","DefaultValue":"1023","Type":"int","Condition":"ANALOGAXES_COUNT>=3","Max":1023}
+
+#define ANALOGAXIS4_INPUT 3          //{"Name":"ANALOGAXIS4_INPUT","Title":"4th axis analog input (0 for A0)","DefaultValue":"3","Type":"int","Condition":"ANALOGAXES_COUNT>=4","Max":11}
+#define ANALOGAXIS4_MIN 0            //{"Name":"ANALOGAXIS4_MIN","Title":"4th axis released value (0-1023)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=4","Max":1023}
+#define ANALOGAXIS4_MAX 1023         //{"Name":"ANALOGAXIS4_MAX","Title":"4th axis fully pressed value (0-1023)","DefaultValue":"1023","Type":"int","Condition":"ANALOGAXES_COUNT>=4","Max":1023}
+
+#define ANALOGAXIS5_INPUT 4          //{"Name":"ANALOGAXIS5_INPUT","Title":"5th axis analog input (0 for A0)","DefaultValue":"4","Type":"int","Condition":"ANALOGAXES_COUNT>=5","Max":11}
+#define ANALOGAXIS5_MIN 0            //{"Name":"ANALOGAXIS5_MIN","Title":"5th axis released value (0-1023)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=5","Max":1023}
+#define ANALOGAXIS5_MAX 1023         //{"Name":"ANALOGAXIS5_MAX","Title":"5th axis fully pressed value (0-1023)","DefaultValue":"1023","Type":"int","Condition":"ANALOGAXES_COUNT>=5","Max":1023}
+
+#define ANALOGAXIS6_INPUT 5          //{"Name":"ANALOGAXIS6_INPUT","Title":"6th axis analog input (0 for A0)","DefaultValue":"5","Type":"int","Condition":"ANALOGAXES_COUNT>=6","Max":11}
+#define ANALOGAXIS6_MIN 0            //{"Name":"ANALOGAXIS6_MIN","Title":"6th axis released value (0-1023)","DefaultValue":"0","Type":"int","Condition":"ANALOGAXES_COUNT>=6","Max":1023}
+#define ANALOGAXIS6_MAX 1023         //{"Name":"ANALOGAXIS6_MAX","Title":"6th axis fully pressed value (0-1023)","DefaultValue":"1023","Type":"int","Condition":"ANALOGAXES_COUNT>=6","Max":1023}
+#include "SHAnalogAxes.h"
+#endif
+
 
 // -------------------- SHAKEIT ADA MOTOR SHIELD V2 -------------------------------------------------------
 // https://github.com/zegreatclan/SimHub/wiki/Arduino-Shake-It
@@ -540,7 +618,7 @@ SHShakeitDKMotorShield shShakeitDKMotorShield;
 #define L98N_in3 7           //{"Name":"L98N_in3","Title":"IN3 digital pin","DefaultValue":"7","Type":"pin;L298N IN3","Condition":"L98NMOTORS_ENABLED>=1"}
 #define L98N_in4 6           //{"Name":"L98N_in4","Title":"IN4 digital pin","DefaultValue":"6","Type":"pin;L298N IN4","Condition":"L98NMOTORS_ENABLED>=1"}
 #include "SHShakeitL298N.h"
-SHShakeitL298N shShakeitL298N;
+SHShakeitL298N<L98N_enA, L98N_enB, L98N_in1, L98N_in2, L98N_in3, L98N_in4> shShakeitL298N;
 #endif
 
 // -------------------- SHAKEIT PWM OUTPUT ----------------------------------------------------------------
@@ -565,6 +643,22 @@ SHShakeitL298N shShakeitL298N;
 SHShakeitPWM shShakeitPWM;
 #endif
 
+// -------------------- SHAKEIT HAPTIC EFFECTS ------------------------------------------------------------
+// Effects (waveform, frequency, envelope) synthesized on the device and added to the motors outputs
+// --------------------------------------------------------------------------------------------------------
+#ifdef INCLUDE_HAPTICS
+#define HAPTICS_RATE_HZ 500 //{"Group":"SHAKEIT Haptic effects","Name":"HAPTICS_RATE_HZ","Title":"Haptic effects synthesis rate (Hz)","DefaultValue":"500","Type":"int","Min":100,"Max":1000}
+#include "SHHaptics.h"
+#endif
+
+// -------------------- GLCD RETAINED LAYOUT AND BITMAPS --------------------------------------------------
+// RAM taken by the OLED and Nokia screens on top of their frame buffer :
+// 25 bytes per layout item, 9 bytes per value slot, the bitmap cache size plus 28 bytes when enabled
+// --------------------------------------------------------------------------------------------------------
+#define GLCD_LAYOUT_MAXITEMS 4    //{"Group":"GLCD layout and bitmaps","Name":"GLCD_LAYOUT_MAXITEMS","Title":"Retained layout items (25 bytes of RAM each)","DefaultValue":"4","Type":"int","Min":1,"Max":16}
+#define GLCD_LAYOUT_MAXSLOTS 4    //{"Name":"GLCD_LAYOUT_MAXSLOTS","Title":"Layout value slots (9 bytes of RAM each)","DefaultValue":"4","Type":"int","Min":1,"Max":16}
+#define GLCD_BITMAP_CACHESIZE 0   //{"Name":"GLCD_BITMAP_CACHESIZE","Title":"Stored bitmaps cache size in bytes, 0 to disable","DefaultValue":"0","Type":"int","Max":512}
+
 // -------------------- OLED GLCD -------------------------------------------------------------------------
 // https://github.com/zegreatclan/SimHub/wiki/Arduino-SSD1306-0.96''-Oled-I2C
 // --------------------------------------------------------------------------------------------------------
@@ -602,15 +696,12 @@ int RS_74HC595_INVERT = 0;
 #define RS_74HC595_DATAPIN 2          //{"Name":"RS_74HC595_DATAPIN","Title":"DATA digital pin number","DefaultValue":"2","Type":"pin","Condition":"ENABLE_74HC595_GEAR_DISPLAY >0"}
 #define RS_74HC595_LATCHPIN 3         //{"Name":"RS_74HC595_LATCHPIN","Title":"LATCH digital pin number","DefaultValue":"3","Type":"pin","Condition":"ENABLE_74HC595_GEAR_DISPLAY > 0"}
 #define RS_74HC595_CLOCKPIN 4         //{"Name":"RS_74HC595_CLOCKPIN","Title":"CLOCK digital pin number","DefaultValue":"4","Type":"pin","Condition":"ENABLE_74HC595_GEAR_DISPLAY > 0"}
+#define RS_74HC595_DIGITS 1           //{"Name":"RS_74HC595_DIGITS","Title":"Chained 74HC595 digits, the first one shows the gear\r\nHardware SPI is used when DATA and CLOCK are the MOSI and SCK pins (11 and 13 on uno)","DefaultValue":"1","Type":"int","Max":4,"Condition":"ENABLE_74HC595_GEAR_DISPLAY > 0"}
 // RS_74HC595 DIGITS
-// 0,1,2 ....
-byte RS_74HC595_dec_digits[] = { 0b11111100, 0b01100000, 0b11011010, 0b11110010, 0b01100110, 0b10110110, 0b10111110, 0b11100000, 0b11111110, 0b11110110 };
-// Empty
-byte RS_74HC595_ClearDigit = 0b00000000;
-// R
-byte RS_74HC595_ReverseDigit = 0b10001100;
-// N
-byte RS_74HC595_NeutralDigit = 0b11101100;
+// 0,1,2 ...., Empty, R, N
+byte RS_74HC595_font[] = { 0b11111100, 0b01100000, 0b11011010, 0b11110010, 0b01100110, 0b10110110, 0b10111110, 0b11100000, 0b11111110, 0b11110110, 0b00000000, 0b10001100, 0b11101100 };
+#include "SHGearDisplay595.h"
+SHGearDisplay595<RS_74HC595_DATAPIN, RS_74HC595_CLOCKPIN, RS_74HC595_LATCHPIN> RS_74HC595;
 #endif // INCLUDE_74HC595_GEAR_DISPLAY
 
 // --------------------------------------------------------------------------------------------------------
@@ -622,6 +713,7 @@ byte RS_74HC595_NeutralDigit = 0b11101100;
 #define RS_6c595_DATAPIN 11         //{"Name":"RS_6c595_DATAPIN","Title":"DATA digital pin number, can't be changed !","DefaultValue":"11","Type":"pin","Condition":"ENABLE_6C595_GEAR_DISPLAY>0"}
 #define RS_6c595_LATCHPIN 13        //{"Name":"RS_6c595_LATCHPIN","Title":"LATCH digital pin number, can't be changed !","DefaultValue":"13","Type":"pin","Condition":"ENABLE_6C595_GEAR_DISPLAY>0"}
 #define RS_6c595_SLAVEPIN 10        //{"Name":"RS_6c595_SLAVEPIN","Title":"SLAVE digital pin number","DefaultValue":"10","Type":"pin","Condition":"ENABLE_6C595_GEAR_DISPLAY>0"}
+#define RS_6c595_DIGITS 1           //{"Name":"RS_6c595_DIGITS","Title":"Chained 6c595 digits, the first one shows the gear","DefaultValue":"1","Type":"int","Max":4,"Condition":"ENABLE_6C595_GEAR_DISPLAY>0"}
 byte g_6c595fontArray[] = {
 	// dp-a-b-c-d-e-f-g
 	0b10100001, // 0
@@ -636,98 +728,58 @@ byte g_6c595fontArray[] = {
 	0b01111111, // 9
 	0b00000000, // OFF empty
 	0b10000001, // REVERSE SPEED
+	0b10100001, // NEUTRAL (0)
 };
-byte g_6c595LEDarray; //computed order that will be sent to the LED display
+#include "SHGearDisplay595.h"
+// RS_6c595_LATCHPIN is wired to the shift register clock (SRCLK), RS_6c595_SLAVEPIN to RCLK
+SHGearDisplay595<RS_6c595_DATAPIN, RS_6c595_LATCHPIN, RS_6c595_SLAVEPIN> RS_6c595;
 #endif
 
 #include "SHLedsBackpack.h"
 
-#ifdef INCLUDE_74HC595_GEAR_DISPLAY
-void RS_74HC595_SendData(byte data) {
-	// take the latchPin low so
-	// the LEDs don't change while you're sending in bits:
-	digitalWrite(RS_74HC595_LATCHPIN, LOW);
-	// shift out the bits:
-	shiftOut(RS_74HC595_DATAPIN, RS_74HC595_CLOCKPIN, MSBFIRST, data);
-	//take the latch pin high so the LEDs will light up:
-	digitalWrite(RS_74HC595_LATCHPIN, HIGH);
-}
-
-void RS_74HC595_SetChar(char c) {
-	byte data = 0;
-	if (c == ' ') {
-		data = RS_74HC595_ClearDigit;
-	}
-	else if (c == 'R') {
-		data = RS_74HC595_ReverseDigit;
-	}
-	else if (c == 'N') {
-		data = RS_74HC595_NeutralDigit;
-	}
-	else {
-		int value = c - '0';
-		if (value >= 0 && value < 10) {
-			data = RS_74HC595_dec_digits[value];
-		}
-	}
-
-	if (RS_74HC595_INVERT == 1) {
-		data = data ^ 0xFF;
-	}
-	RS_74HC595_SendData(data);
-}
-
-void RS_74HC595_Init() {
-	//set pins to output so you can control the shift register
-	pinMode(RS_74HC595_DATAPIN, OUTPUT);
-	pinMode(RS_74HC595_LATCHPIN, OUTPUT);
-	pinMode(RS_74HC595_CLOCKPIN, OUTPUT);
-	RS_74HC595_SetChar(' ');
-}
-#endif // INCLUDE_74HC595_GEAR_DISPLAY
-
-#ifdef INCLUDE_6c595_GEAR_DISPLAY
-void RS_6c595_SetChar(char c) {
-	byte data = 0;
-	if (c == ' ') {
-		data = g_6c595fontArray[10];
-	}
-	else if (c == 'R') {
-		data = g_6c595fontArray[11];
-	}
-	else if (c == 'N') {
-		data = g_6c595fontArray[0];
-	}
-	else {
-		int value = c - '0';
-		if (value >= 0 && value < 10) {
-			data = g_6c595fontArray[value];
-		}
-	}
-	digitalWrite(RS_6c595_SLAVEPIN, LOW); // << RCLK line goes low
-	SPI.transfer(data);  //  << SRCLK goes  high-low 8 times to output 8 bits of data
-	digitalWrite(RS_6c595_SLAVEPIN, HIGH); // data outputs change on this rising edge << RCLK line goes high to move data into output register
-}
-#endif //INCLUDE_6c595_GEAR_DISPLAY
-
 #ifdef INCLUDE_GAMEPAD
 #include <Joystick.h>
 
 //initialize an Joystick with 34 buttons;
 Joystick_ Joystick(JOYSTICK_DEFAULT_REPORT_ID,
 	JOYSTICK_TYPE_JOYSTICK, 128, 0,
-	false, false, false, false, false, false,
+	ANALOGAXES_COUNT > 0, ANALOGAXES_COUNT > 1, ANALOGAXES_COUNT > 2, ANALOGAXES_COUNT > 3, ANALOGAXES_COUNT > 4, ANALOGAXES_COUNT > 5,
 	false, false, false, false, false);
 
+#include "SHGamepad.h"
+SHGamepad gamepad;
+
 #endif
 
 #include "SHCustomProtocol.h"
 SHCustomProtocol shCustomProtocol;
+#include "SHSegmentFormat.h"
 #include "SHCommands.h"
 #include "SHCommandsGlcd.h"
 
 void idle(bool critical) {
+#ifdef INCLUDE_I2CQUEUE
+	// A whole I2C transaction is too long while receiving a packet
+	if (!critical) {
+		i2cQueue.pump();
+	}
+#endif
+
+	inputsDebouncer.update();
+
+#ifdef INCLUDE_ANALOGAXES
+	analogAxes.update();
+#endif
+
+#ifdef INCLUDE_HAPTICS
+	// Motor writes may go to the I2C queue, which isn't pumped while receiving a packet
+	if (!critical) {
+		haptics.update();
+	}
+#endif
+
 #ifdef  INCLUDE_ENCODERS
+	SHRotaryEncoder_ProcessEvents();
 	for (int i = 0; i < ENABLED_ENCODERS_COUNT; i++) {
 		SHRotaryEncoders[i]->read();
 	}
@@ -737,13 +789,18 @@ void idle(bool critical) {
 	shButtonMatrix.read();
 #endif
 
-	if (ButtonsDebouncer.Debounce()) {
-		bool changed = false;
+#ifdef INCLUDE_74HC165
+	sh74HC165.read();
+#endif
+
 #ifdef INCLUDE_BUTTONS
-		for (int btnIdx = 0; btnIdx < ENABLED_BUTTONS_COUNT; btnIdx++) {
-			BUTTONS[btnIdx]->read();
-		}
+	for (int btnIdx = 0; btnIdx < ENABLED_BUTTONS_COUNT; btnIdx++) {
+		BUTTONS[btnIdx]->read();
+	}
 #endif
+
+	if (ButtonsDebouncer.Debounce()) {
+		bool changed = false;
 #ifdef INCLUDE_TM1638
 		for (int i = 0; i < TM1638_ENABLEDMODULES; i++) {
 			TM1638_screens[i]->Buttons = TM1638_screens[i]->Screen->getButtons();
@@ -754,11 +811,7 @@ void idle(bool critical) {
 				for (int b = 0; b < 8; b++) {
 					mask = 0b1 << b;
 					if ((TM1638_screens[i]->Buttons & mask) != (TM1638_screens[i]->Oldbuttons & mask)) {
-						arqserial.CustomPacketStart(0x04, 3);
-						arqserial.CustomPacketSendByte(i + 1);
-						arqserial.CustomPacketSendByte(b + 1);
-						arqserial.CustomPacketSendByte((TM1638_screens[i]->Oldbuttons & mask) > 0 ? 0 : 1);
-						arqserial.CustomPacketEnd();
+						inputEvents.push(INPUTEVENT_TM1638BUTTON, i + 1, b + 1, (TM1638_screens[i]->Oldbuttons & mask) > 0 ? 0 : 1);
 					}
 				}
 			}
@@ -772,51 +825,67 @@ void idle(bool critical) {
 #endif
 		shCustomProtocol.idle();
 	}
+
+	inputEvents.update();
+#ifdef INCLUDE_GAMEPAD
+	gamepad.update();
+#endif
 }
 
 #ifdef  INCLUDE_ENCODERS
 void EncoderPositionChanged(int encoderId, int position, byte direction) {
 	if (direction < 2) {
-		arqserial.CustomPacketStart(0x01, 3);
-		arqserial.CustomPacketSendByte(encoderId);
-		arqserial.CustomPacketSendByte(direction);
-		arqserial.CustomPacketSendByte(position);
-		arqserial.CustomPacketEnd();
+		inputEvents.push(INPUTEVENT_ENCODER, encoderId, direction, position);
 	}
 	else {
-		arqserial.CustomPacketStart(0x02, 2);
-		arqserial.CustomPacketSendByte(encoderId);
-		arqserial.CustomPacketSendByte(direction - 2);
-		arqserial.CustomPacketEnd();
+		inputEvents.push(INPUTEVENT_ENCODERBUTTON, encoderId, direction - 2);
 	}
 #ifdef INCLUDE_GAMEPAD
-	UpdateGamepadEncodersState(true);
+	UpdateGamepadEncodersState();
+#endif
+}
+
+void EncoderDeltaChanged(int encoderId, int delta, int position) {
+	inputEvents.push(INPUTEVENT_ENCODERDELTA, encoderId, (int8_t)delta, position);
+#ifdef INCLUDE_GAMEPAD
+	UpdateGamepadEncodersState();
 #endif
 }
 #endif
 
 void buttonStatusChanged(int buttonId, byte Status) {
-	arqserial.CustomPacketStart(0x03, 2);
-	arqserial.CustomPacketSendByte(buttonId);
-	arqserial.CustomPacketSendByte(Status);
-	arqserial.CustomPacketEnd();
+	inputEvents.push(INPUTEVENT_BUTTON, buttonId, Status);
 
 #ifdef INCLUDE_GAMEPAD
-	Joystick.setButton(TM1638_ENABLEDMODULES * 8 + buttonId - 1, Status);
-	Joystick.sendState();
+	gamepad.setButton(TM1638_ENABLEDMODULES * 8 + buttonId - 1, Status);
 #endif
 }
 
+#ifdef INCLUDE_74HC165
+void shiftRegisterButtonStatusChanged(int buttonId, byte Status) {
+	int offset = ENABLED_BUTTONS_COUNT + ENABLED_BUTTONMATRIX * (BMATRIX_COLS * BMATRIX_ROWS);
+	inputEvents.push(INPUTEVENT_BUTTON, offset + buttonId, Status);
+
+#ifdef INCLUDE_GAMEPAD
+	gamepad.setButton(TM1638_ENABLEDMODULES * 8 + offset + buttonId - 1, Status);
+#endif
+}
+#endif
+
+#ifdef INCLUDE_ANALOGAXES
+void analogAxisChanged(uint8_t axis, uint16_t value) {
+#ifdef INCLUDE_GAMEPAD
+	gamepad.setAxis(axis, value);
+#endif
+}
+#endif
+
 #ifdef  INCLUDE_BUTTONMATRIX
 void buttonMatrixStatusChanged(int buttonId, byte Status) {
-	arqserial.CustomPacketStart(0x03, 2);
-	arqserial.CustomPacketSendByte(ENABLED_BUTTONS_COUNT + buttonId);
-	arqserial.CustomPacketSendByte(Status);
-	arqserial.CustomPacketEnd();
+	inputEvents.push(INPUTEVENT_BUTTON, ENABLED_BUTTONS_COUNT + buttonId, Status);
 
 #ifdef INCLUDE_GAMEPAD
-	Joystick.setButton(TM1638_ENABLEDMODULES * 8 + ENABLED_BUTTONS_COUNT + buttonId - 1, Status);
-	Joystick.sendState();
+	gamepad.setButton(TM1638_ENABLEDMODULES * 8 + ENABLED_BUTTONS_COUNT + buttonId - 1, Status);
 #endif
 
 }
@@ -828,7 +897,7 @@ void setup()
 	FlowSerialBegin(19200);
 
 #ifdef INCLUDE_GAMEPAD
-	Joystick.begin(false);
+	gamepad.begin(&Joystick);
 #endif
 
 #ifdef INCLUDE_TM1638
@@ -858,18 +927,18 @@ void setup()
 #endif
 
 #ifdef INCLUDE_MAX7221_MODULES
-	shMAX72217Segment.begin(MAX7221_ENABLEDMODULES, MAX7221_DATA, MAX7221_CLK, MAX7221_LOAD);
+	shMAX72217Segment.begin(MAX7221_ENABLEDMODULES);
 #endif
 
 #ifdef INCLUDE_MAX7221MATRIX
-	shMatrixMAX7219.begin(MAX7221_MATRIX_DATA, MAX7221_MATRIX_CLK, MAX7221_MATRIX_LOAD);
+	shMatrixMAX7219.begin();
 #endif
 
 	// 74HC595 INIT
 #ifdef INCLUDE_74HC595_GEAR_DISPLAY
 	if (ENABLE_74HC595_GEAR_DISPLAY == 1)
 	{
-		RS_74HC595_Init();
+		RS_74HC595.begin(RS_74HC595_DIGITS, RS_74HC595_font, RS_74HC595_INVERT, ' ');
 	}
 #endif
 
@@ -883,19 +952,13 @@ void setup()
 
 #ifdef INCLUDE_6c595_GEAR_DISPLAY
 	if (ENABLE_6C595_GEAR_DISPLAY == 1) {
-		pinMode(RS_6c595_DATAPIN, OUTPUT);
-		pinMode(RS_6c595_LATCHPIN, OUTPUT);
-		pinMode(RS_6c595_SLAVEPIN, OUTPUT);
-		SPI.begin();
-		digitalWrite(RS_6c595_SLAVEPIN, LOW); // << RCLK line goes low
-		SPI.transfer(g_6c595fontArray[8]);  //  << SRCLK goes  high-low 8 times to output 8 bits of data
-		digitalWrite(RS_6c595_SLAVEPIN, HIGH); // data outputs change on this rising edge << RCLK line goes high to move data into output register
+		RS_6c595.begin(RS_6c595_DIGITS, g_6c595fontArray, 0, '8');
 	}
 #endif
 
 	// LCD INIT
 #ifdef INCLUDE_I2CLCD
-	shI2CLcd.begin(&I2CLCD, I2CLCD_WIDTH, I2CLCD_HEIGHT, I2CLCD_TEST);
+	shI2CLcd.begin(&I2CLCD, I2CLCD_ADDRESS, I2CLCD_WIDTH, I2CLCD_HEIGHT, I2CLCD_TEST);
 #endif
 
 #ifdef INCLUDE_LEDBACKPACK
@@ -907,6 +970,9 @@ void setup()
 	// ADA_HT16K33_MATRIX INIT
 	if (ENABLE_ADA_HT16K33_BiColorMatrix == 1) {
 		ADA_HT16K33_MATRIX.begin(ADA_HT16K33_BICOLORMATRIX_I2CADDRESS);
+		// Display RAM contents are unknown after power up, frames are compared to the cleared buffer
+		ADA_HT16K33_MATRIX.clear();
+		ADA_HT16K33_MATRIX.writeDisplay();
 	}
 #endif
 #ifdef INCLUDE_HT16K33_SINGLECOLORMATRIX
@@ -930,7 +996,15 @@ void setup()
 #endif
 
 #ifdef  INCLUDE_BUTTONMATRIX
-	shButtonMatrix.begin(BMATRIX_COLS, BMATRIX_ROWS, BMATRIX_COLSDEF, BMATRIX_ROWSDEF, buttonMatrixStatusChanged);
+	shButtonMatrix.begin(BMATRIX_COLS, BMATRIX_ROWS, BMATRIX_COLSDEF, BMATRIX_ROWSDEF, BMATRIX_GHOSTDETECTION, buttonMatrixStatusChanged);
+#endif
+
+#ifdef INCLUDE_74HC165
+	sh74HC165.begin(ENABLED_74HC165_CHIPS, SR165_ACTIVE_LOW, shiftRegisterButtonStatusChanged);
+#endif
+
+#ifdef INCLUDE_ANALOGAXES
+	InitAnalogAxes();
 #endif
 
 
@@ -941,7 +1015,7 @@ void setup()
 	shShakeitAdaMotorShieldV2.begin(ADAMOTORS_SHIELDSCOUNT, ADAMOTORS_FREQ);
 #endif
 #ifdef  INCLUDE_SHAKEITL298N
-	shShakeitL298N.begin(L98N_enA, L98N_enB, L98N_in1, L98N_in2, L98N_in3, L98N_in4);
+	shShakeitL298N.begin();
 #endif
 #ifdef INCLUDE_SHAKEITMOTOMONSTER
 	shShakeitMotoMonster.begin(MOTOMONSTER_REVERSEDIRECTION);
@@ -953,6 +1027,25 @@ void setup()
 	shShakeitPWM.setMax(SHAKEITPWM_MAX_OUTPUT_O1, SHAKEITPWM_MAX_OUTPUT_O2, SHAKEITPWM_MAX_OUTPUT_O3, SHAKEITPWM_MAX_OUTPUT_O4);
 #endif
 
+#ifdef INCLUDE_HAPTICS
+	// Same order as the motors frame
+#ifdef INCLUDE_SHAKEITADASHIELD
+	haptics.addProvider(&shShakeitAdaMotorShieldV2);
+#endif
+#ifdef INCLUDE_SHAKEITDKSHIELD
+	haptics.addProvider(&shShakeitDKMotorShield);
+#endif
+#ifdef INCLUDE_SHAKEITL298N
+	haptics.addProvider(&shShakeitL298N);
+#endif
+#ifdef INCLUDE_SHAKEITMOTOMONSTER
+	haptics.addProvider(&shShakeitMotoMonster);
+#endif
+#ifdef INCLUDE_SHAKEITPWM
+	haptics.addProvider(&shShakeitPWM);
+#endif
+#endif
+
 #ifdef  INCLUDE_ENCODERS
 	InitEncoders();
 #endif
@@ -971,10 +1064,30 @@ void InitEncoders() {
 	if (ENABLED_ENCODERS_COUNT > 5) encoder6.begin(ENCODER6_CLK_PIN, ENCODER6_DT_PIN, ENCODER6_BUTTON_PIN, ENCODER6_REVERSE_DIRECTION, ENCODER6_ENABLE_PULLUP, 6, ENCODER6_ENABLE_HALFSTEPS, EncoderPositionChanged);
 	if (ENABLED_ENCODERS_COUNT > 6) encoder7.begin(ENCODER7_CLK_PIN, ENCODER7_DT_PIN, ENCODER7_BUTTON_PIN, ENCODER7_REVERSE_DIRECTION, ENCODER7_ENABLE_PULLUP, 7, ENCODER7_ENABLE_HALFSTEPS, EncoderPositionChanged);
 	if (ENABLED_ENCODERS_COUNT > 7) encoder8.begin(ENCODER8_CLK_PIN, ENCODER8_DT_PIN, ENCODER8_BUTTON_PIN, ENCODER8_REVERSE_DIRECTION, ENCODER8_ENABLE_PULLUP, 8, ENCODER8_ENABLE_HALFSTEPS, EncoderPositionChanged);
+	encodersDeltaCallback = EncoderDeltaChanged;
 }
 
 #endif
 
+#ifdef INCLUDE_ANALOGAXES
+void InitAnalogAxes() {
+	if (ANALOGAXES_COUNT > 0) analogAxes.addAxis(ANALOGAXIS1_INPUT, ANALOGAXIS1_MIN, ANALOGAXIS1_MAX, ANALOGAXES_DEADZONE_LOW, ANALOGAXES_DEADZONE_HIGH);
+	if (ANALOGAXES_COUNT > 1) analogAxes.addAxis(ANALOGAXIS2_INPUT, ANALOGAXIS2_MIN, ANALOGAXIS2_MAX, ANALOGAXES_DEADZONE_LOW, ANALOGAXES_DEADZONE_HIGH);
+	if (ANALOGAXES_COUNT > 2) analogAxes.addAxis(ANALOGAXIS3_INPUT, ANALOGAXIS3_MIN, ANALOGAXIS3_MAX, ANALOGAXES_DEADZONE_LOW, ANALOGAXES_DEADZONE_HIGH);
+	if (ANALOGAXES_COUNT > 3) analogAxes.addAxis(ANALOGAXIS4_INPUT, ANALOGAXIS4_MIN, ANALOGAXIS4_MAX, ANALOGAXES_DEADZONE_LOW, ANALOGAXES_DEADZONE_HIGH);
+	if (ANALOGAXES_COUNT > 4) analogAxes.addAxis(ANALOGAXIS5_INPUT, ANALOGAXIS5_MIN, ANALOGAXIS5_MAX, ANALOGAXES_DEADZONE_LOW, ANALOGAXES_DEADZONE_HIGH);
+	if (ANALOGAXES_COUNT > 5) analogAxes.addAxis(ANALOGAXIS6_INPUT, ANALOGAXIS6_MIN, ANALOGAXIS6_MAX, ANALOGAXES_DEADZONE_LOW, ANALOGAXES_DEADZONE_HIGH);
+
+#ifdef INCLUDE_GAMEPAD
+	for (int i = 0; i < ANALOGAXES_COUNT; i++) {
+		gamepad.setAxisRange(i, 0, ANALOGAXES_OUTPUT_MAX);
+	}
+#endif
+
+	analogAxes.start(analogAxisChanged);
+}
+#endif
+
 #ifdef INCLUDE_GAMEPAD
 void UpdateGamepadState() {
 	int btnidx = 0;
@@ -984,34 +1097,31 @@ void UpdateGamepadState() {
 		byte buttonsState = TM1638_screens[i]->Buttons;
 
 		for (int i = 0; i < 8; i++) {
-			Joystick.setButton(btnidx, buttonsState & (1 << i));
+			gamepad.setButton(btnidx, buttonsState & (1 << i));
 			btnidx++;
 		}
 	}
 #endif
 
 #ifdef INCLUDE_ENCODERS
-	UpdateGamepadEncodersState(false);
+	UpdateGamepadEncodersState();
 #endif
 
-	Joystick.sendState();
+	gamepad.update();
 }
 
 #ifdef INCLUDE_ENCODERS
-void UpdateGamepadEncodersState(bool sendState) {
-	int btnidx = TM1638_ENABLEDMODULES * 8 + ENABLED_BUTTONS_COUNT + ENABLED_BUTTONMATRIX * (BMATRIX_COLS * BMATRIX_ROWS);
+void UpdateGamepadEncodersState() {
+	int btnidx = TM1638_ENABLEDMODULES * 8 + ENABLED_BUTTONS_COUNT + ENABLED_BUTTONMATRIX * (BMATRIX_COLS * BMATRIX_ROWS) + ENABLED_74HC165_CHIPS * 8;
 	unsigned long refTime = millis();
 	for (int i = 0; i < ENABLED_ENCODERS_COUNT; i++) {
 		uint8_t dir = SHRotaryEncoders[i]->getDirection(MICRO_GAMEPAD_ENCODERPRESSTIME, refTime);
-		Joystick.setButton(btnidx, dir == 0);
-		Joystick.setButton(btnidx + 1, dir == 1);
-		Joystick.setButton(btnidx + 2, SHRotaryEncoders[i]->getPressed());
+		gamepad.setButton(btnidx, dir == 0);
+		gamepad.setButton(btnidx + 1, dir == 1);
+		gamepad.setButton(btnidx + 2, SHRotaryEncoders[i]->getPressed());
 
 		btnidx += 3;
 	}
-
-	if (sendState)
-		Joystick.sendState();
 }
 #endif
 
@@ -1034,12 +1144,23 @@ void loop() {
 #ifdef INCLUDE_SHAKEITPWM
 	shShakeitPWM.safetyCheck();
 #endif
+#ifdef INCLUDE_HAPTICS
+	haptics.update();
+#endif
+#ifdef INCLUDE_ANALOGAXES
+	analogAxes.update();
+#endif
 #ifdef INCLUDE_GAMEPAD
 	UpdateGamepadState();
 #endif
+#ifdef INCLUDE_I2CQUEUE
+	i2cQueue.pump();
+#endif
 
 	shCustomProtocol.loop();
 
+	inputEvents.update();
+
 	// Wait for data
 	if (FlowSerialAvailable() > 0) {
 		if (FlowSerialTimedRead() == MESSAGE_HEADER)
@@ -1078,6 +1199,16 @@ void loop() {
 				else if (xaction == F("fuel")) Command_FuelData();
 				else if (xaction == F("cons")) Command_ConsData();
 				else if (xaction == F("encoderscount")) Command_EncodersCount();
+				else if (xaction == F("lcdwidget")) Command_I2CLCDWidgets();
+				else if (xaction == F("tm1637")) Command_TM1637CompactData();
+				else if (xaction == F("segvalues")) Command_7SegmentsValues();
+				else if (xaction == F("geardigits")) Command_GearDigits();
+				else if (xaction == F("inputevents")) Command_InputEventsMode();
+				else if (xaction == F("encoderdeltas")) Command_EncoderDeltasMode();
+				else if (xaction == F("analogaxes")) Command_AnalogAxesPacket();
+				else if (xaction == F("axiscalibration")) Command_AnalogAxisCalibration();
+				else if (xaction == F("haptic")) Command_HapticEffect();
+				else if (xaction == F("hapticstop")) Command_HapticStop();
 
 			}
 		}
@@ -0,0 +1,103 @@
+#ifndef __SH74HC165_H__
+#define __SH74HC165_H__
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "SHFastIO.h"
+#include "SHPortDebouncer.h"
+
+#define SR165_MAXCHIPS 8
+
+typedef void(*SH74HC165Changed) (int, byte);
+
+// Buttons on chained 74HC165 parallel in shift registers, read with hardware SPI :
+// QH of the first chip to MISO, CLK to SCK, SH/LD to LOADPIN, CLK INH to ground.
+// The whole chain is loaded then shifted in one burst (about 12us for 8 chips at 8MHz),
+// every DEBOUNCE_SAMPLE_US. A change is reported once DEBOUNCE_SAMPLES scans agree.
+// Button 1 is input A of the first chip.
+template <uint8_t LOADPIN>
+class SH74HC165 {
+private:
+	SH74HC165Changed changedCallback;
+	uint8_t chipCount;
+	// Inputs pulled up, pressed buttons read low
+	uint8_t invertMask;
+
+	uint8_t history[DEBOUNCE_SAMPLES][SR165_MAXCHIPS];
+	uint8_t state[SR165_MAXCHIPS];
+	unsigned long lastSample;
+
+	// Pressed inputs, bit 0 = A
+	void scan(uint8_t * pressed) {
+		// Parallel load while SH/LD is low
+		FastPin<LOADPIN>::low();
+		FastPin<LOADPIN>::high();
+
+		// H is shifted out first, A ends in bit 0
+		SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+		memset(pressed, 0, chipCount);
+		SPI.transfer(pressed, chipCount);
+		SPI.endTransaction();
+
+		for (uint8_t i = 0; i < chipCount; i++) {
+			pressed[i] ^= invertMask;
+		}
+	}
+
+public:
+
+	void begin(uint8_t chips, bool activeLow, SH74HC165Changed callback) {
+		chipCount = chips < SR165_MAXCHIPS ? chips : SR165_MAXCHIPS;
+		invertMask = activeLow ? 0xFF : 0x00;
+		changedCallback = callback;
+
+		FastPin<LOADPIN>::mode(OUTPUT);
+		FastPin<LOADPIN>::high();
+		SPI.begin();
+
+		// Starts from the current state, buttons held at startup are not reported
+		scan(state);
+		for (uint8_t s = 0; s < DEBOUNCE_SAMPLES; s++) {
+			memcpy(history[s], state, chipCount);
+		}
+		lastSample = micros();
+	}
+
+	uint8_t getButtonsCount() {
+		return chipCount * 8;
+	}
+
+	void read() {
+		unsigned long now = micros();
+		if (now - lastSample < DEBOUNCE_SAMPLE_US)
+			return;
+		lastSample = now;
+
+		for (uint8_t s = DEBOUNCE_SAMPLES - 1; s > 0; s--) {
+			memcpy(history[s], history[s - 1], chipCount);
+		}
+		scan(history[0]);
+
+		for (uint8_t i = 0; i < chipCount; i++) {
+			uint8_t allHigh = 0xFF;
+			uint8_t anyHigh = 0;
+			for (uint8_t s = 0; s < DEBOUNCE_SAMPLES; s++) {
+				allHigh &= history[s][i];
+				anyHigh |= history[s][i];
+			}
+
+			// Stable inputs take the scanned level, the others keep their state
+			uint8_t pressed = allHigh | (state[i] & anyHigh);
+			uint8_t changed = pressed ^ state[i];
+			state[i] = pressed;
+
+			for (uint8_t b = 0; changed; b++, changed >>= 1) {
+				if (changed & 1) {
+					changedCallback(i * 8 + b + 1, (pressed >> b) & 1);
+				}
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef __SHANALOGAXES_H__
+#define __SHANALOGAXES_H__
+
+#include <Arduino.h>
+
+#define ANALOGAXES_MAX 6
+
+// Extra resolution bits (0-3), each axis value is the sum of 4^bits conversions decimated by 2^bits
+#ifndef ANALOGAXES_OVERSAMPLING_BITS
+#define ANALOGAXES_OVERSAMPLING_BITS 1
+#endif
+
+#if ANALOGAXES_OVERSAMPLING_BITS < 0 || ANALOGAXES_OVERSAMPLING_BITS > 3
+#error "ANALOGAXES_OVERSAMPLING_BITS must be between 0 and 3"
+#endif
+
+// Time between two calibration passes
+#ifndef ANALOGAXES_INTERVAL_US
+#define ANALOGAXES_INTERVAL_US 1000
+#endif
+
+#define ANALOGAXES_SAMPLES (1 << (2 * ANALOGAXES_OVERSAMPLING_BITS))
+#define ANALOGAXES_OUTPUT_MAX ((1 << (10 + ANALOGAXES_OVERSAMPLING_BITS)) - 1)
+
+// Output at 0, 25, 50, 75 and 100% of the travel (0-255)
+#define ANALOGAXES_CURVEPOINTS 5
+
+// Axes custom packet : count, then each axis value (uint16, little endian)
+#define ANALOGAXES_PACKET 0x06
+
+struct SHAnalogAxis {
+	uint8_t channel;
+	// Travel ends in 10 bits units, min can be above max for reversed sensors
+	uint16_t min;
+	uint16_t max;
+	// Ignored travel at each end, in percent
+	uint8_t deadzoneLow;
+	uint8_t deadzoneHigh;
+	uint8_t curve[ANALOGAXES_CURVEPOINTS];
+	uint16_t value;
+};
+
+typedef void(*SHAnalogAxisChanged) (uint8_t axis, uint16_t value);
+
+// Analog axes (pedals, handbrake) sampled by the ADC interrupt : each conversion starts the next one,
+// an axis is converted ANALOGAXES_SAMPLES + 1 times (the first conversion after a channel switch is dropped)
+// before moving to the next axis. update() then applies the calibration every ANALOGAXES_INTERVAL_US.
+// analogRead must not be used while the axes are running.
+class SHAnalogAxes {
+private:
+	SHAnalogAxis axes[ANALOGAXES_MAX];
+	uint8_t axesCount = 0;
+	SHAnalogAxisChanged changedCallback;
+	unsigned long lastUpdate;
+
+	// Host packet, 0 disabled
+	uint8_t packetInterval = 0;
+	unsigned long lastPacket;
+	bool packetPending = false;
+
+	// Interrupt state
+	volatile uint16_t samples[ANALOGAXES_MAX];
+	volatile uint8_t updatedAxes = 0;
+	uint8_t currentAxis;
+	uint8_t conversions;
+	uint16_t sum;
+
+	static uint8_t channelOf(uint8_t pin) {
+#if defined(__AVR_ATmega32U4__)
+		if (pin >= 18)
+			pin -= 18;
+		return analogPinToChannel(pin);
+#else
+		return pin >= 14 ? pin - 14 : pin;
+#endif
+	}
+
+	// Digital input buffer off, less noise
+	static void disableDigitalInput(uint8_t channel) {
+#if defined(DIDR2)
+		// ADC8 and above (32U4, Mega)
+		if (channel >= 8) {
+			DIDR2 |= 1 << (channel - 8);
+			return;
+		}
+#endif
+#if defined(DIDR0)
+#if !defined(ADC6D)
+		// ADC6 and ADC7 have no digital input (328P)
+		if (channel >= 6)
+			return;
+#endif
+		DIDR0 |= 1 << channel;
+#endif
+	}
+
+	static void startConversion(uint8_t channel) {
+#if defined(MUX5)
+		ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((channel >> 3) & 0x01) << MUX5);
+#endif
+		ADMUX = (1 << REFS0) | (channel & 0x07);
+		ADCSRA |= (1 << ADSC);
+	}
+
+	uint16_t calibrate(SHAnalogAxis & axis, uint16_t sample) {
+		// Travel ends moved by the deadzones
+		int32_t low = (int32_t)axis.min << ANALOGAXES_OVERSAMPLING_BITS;
+		int32_t high = (int32_t)axis.max << ANALOGAXES_OVERSAMPLING_BITS;
+		int32_t travel = high - low;
+		low += travel * axis.deadzoneLow / 100;
+		high -= travel * axis.deadzoneHigh / 100;
+		if (travel == 0 || (high - low) * travel <= 0)
+			return 0;
+
+		// Travel position, 0-65536
+		int32_t position = ((int32_t)sample - low) * 65536 / (high - low);
+		position = constrain(position, 0, 65536);
+
+		// Curve, 4 segments of 16384
+		uint8_t segment = position >> 14;
+		int32_t fraction = position & 0x3FFF;
+		if (segment == ANALOGAXES_CURVEPOINTS - 1) {
+			segment--;
+			fraction = 0x4000;
+		}
+		int32_t from = axis.curve[segment];
+		int32_t output = (from << 14) + (axis.curve[segment + 1] - from) * fraction;
+
+		// 0 - 255 * 256, then to the output range
+		return (output >> 6) * ANALOGAXES_OUTPUT_MAX / 65280L;
+	}
+
+	void sendPacket() {
+		arqserial.CustomPacketStart(ANALOGAXES_PACKET, 1 + axesCount * 2);
+		arqserial.CustomPacketSendByte(axesCount);
+		for (uint8_t i = 0; i < axesCount; i++) {
+			arqserial.CustomPacketSendByte((uint8_t)axes[i].value);
+			arqserial.CustomPacketSendByte((uint8_t)(axes[i].value >> 8));
+		}
+		arqserial.CustomPacketEnd();
+	}
+
+	friend void SHAnalogAxes_Interrupt();
+
+public:
+
+	// Axes are added before start()
+	void addAxis(uint8_t pin, uint16_t min, uint16_t max, uint8_t deadzoneLow, uint8_t deadzoneHigh) {
+		if (axesCount >= ANALOGAXES_MAX)
+			return;
+
+		SHAnalogAxis & axis = axes[axesCount];
+		axis.channel = channelOf(pin);
+		axis.value = 0;
+		samples[axesCount] = 0;
+		axesCount++;
+
+		setCalibration(axesCount - 1, min, max, deadzoneLow, deadzoneHigh, 0);
+
+		disableDigitalInput(axis.channel);
+	}
+
+	// curve : ANALOGAXES_CURVEPOINTS outputs, linear when null
+	void setCalibration(uint8_t axisIdx, uint16_t min, uint16_t max, uint8_t deadzoneLow, uint8_t deadzoneHigh, const uint8_t * curve) {
+		if (axisIdx >= axesCount)
+			return;
+
+		SHAnalogAxis & axis = axes[axisIdx];
+		axis.min = min;
+		axis.max = max;
+		axis.deadzoneLow = deadzoneLow;
+		axis.deadzoneHigh = deadzoneHigh;
+		for (uint8_t i = 0; i < ANALOGAXES_CURVEPOINTS; i++) {
+			axis.curve[i] = curve ? curve[i] : (uint8_t)(i * 255 / (ANALOGAXES_CURVEPOINTS - 1));
+		}
+	}
+
+	void start(SHAnalogAxisChanged callback) {
+		changedCallback = callback;
+		lastUpdate = micros();
+		if (axesCount == 0)
+			return;
+
+		currentAxis = 0;
+		conversions = 0;
+		sum = 0;
+
+		// ADC clock F_CPU / 64 (250KHz at 16MHz), about 19000 conversions/s
+		ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1);
+		startConversion(axes[0].channel);
+	}
+
+	uint8_t getAxesCount() {
+		return axesCount;
+	}
+
+	// interval : minimum time between two host packets in milliseconds, 0 disables the packets
+	void setPacketInterval(uint8_t interval) {
+		packetInterval = interval;
+		packetPending = interval > 0;
+	}
+
+	// Applies the calibration to the new samples, to be called from loop() and idle()
+	void update() {
+		unsigned long now = micros();
+		if (now - lastUpdate >= ANALOGAXES_INTERVAL_US) {
+			lastUpdate = now;
+
+			noInterrupts();
+			uint8_t updated = updatedAxes;
+			updatedAxes = 0;
+			interrupts();
+
+			for (uint8_t i = 0; i < axesCount; i++) {
+				if (!(updated & (1 << i)))
+					continue;
+
+				noInterrupts();
+				uint16_t sample = samples[i];
+				interrupts();
+
+				uint16_t value = calibrate(axes[i], sample);
+				if (value != axes[i].value) {
+					axes[i].value = value;
+					packetPending = packetInterval > 0;
+					if (changedCallback)
+						changedCallback(i, value);
+				}
+			}
+		}
+
+		if (packetPending && millis() - lastPacket >= packetInterval) {
+			sendPacket();
+			lastPacket = millis();
+			packetPending = false;
+		}
+	}
+};
+
+SHAnalogAxes analogAxes;
+
+void SHAnalogAxes_Interrupt() {
+	SHAnalogAxes & a = analogAxes;
+	uint16_t sample = ADC;
+
+	// The first conversion after a channel switch is dropped
+	if (a.conversions > 0) {
+		a.sum += sample;
+	}
+
+	if (a.conversions++ == ANALOGAXES_SAMPLES) {
+		a.samples[a.currentAxis] = a.sum >> ANALOGAXES_OVERSAMPLING_BITS;
+		a.updatedAxes |= 1 << a.currentAxis;
+
+		a.currentAxis = a.currentAxis + 1 < a.axesCount ? a.currentAxis + 1 : 0;
+		a.conversions = 0;
+		a.sum = 0;
+	}
+
+	SHAnalogAxes::startConversion(a.axes[a.currentAxis].channel);
+}
+
+ISR(ADC_vect) {
+	SHAnalogAxes_Interrupt();
+}
+
+#endif
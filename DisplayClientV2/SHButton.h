@@ -2,7 +2,7 @@
 #define __SHBUTTON_H__
 
 #include <Arduino.h>
-#include "SHFastIO.h"
+#include "SHPortDebouncer.h"
 
 typedef void(*SHButtonChanged) (int, byte);
 
@@ -10,22 +10,20 @@ class SHButton {
 
 private:
 
-	FastDigitalPin button;
-	uint8_t buttonState;
+	uint8_t input = DEBOUNCER_NOPIN;
 	int buttonLastState;
-	unsigned long buttonLastStateChanged;
 	byte id;
 	SHButtonChanged shButtonChangedCallback;
 
 public:
 
 	void begin(byte buttonid, uint8_t buttonPin, SHButtonChanged changedcallback) {
-		button.begin(buttonPin);
 		if (buttonPin > 0) {
 			pinMode(buttonPin, INPUT_PULLUP);
 		}
+		input = inputsDebouncer.addPin(buttonPin);
 		id = buttonid;
-		buttonLastState = button.digitalRead();
+		buttonLastState = input != DEBOUNCER_NOPIN ? inputsDebouncer.digitalRead(input) : HIGH;
 		shButtonChangedCallback = changedcallback;
 	}
 
@@ -33,12 +31,15 @@ public:
 		return !buttonLastState;
 	}
 
+	// Debounced by inputsDebouncer, to be called after inputsDebouncer.update()
 	void read() {
-		buttonState = button.digitalRead();
-		if (buttonState != buttonLastState && buttonLastStateChanged - millis() > 50) {
+		if (input == DEBOUNCER_NOPIN)
+			return;
+
+		int buttonState = inputsDebouncer.digitalRead(input);
+		if (buttonState != buttonLastState) {
 			shButtonChangedCallback(id, buttonState == HIGH ? 0 : 1);
 			buttonLastState = buttonState;
-			buttonLastStateChanged = millis();
 		}
 	}
 };
@@ -2,91 +2,142 @@
 #define __SHBUTTONMATRIX_H__
 
 #include <Arduino.h>
+#include "SHFastIO.h"
 #include "SHDebouncer.h"
 
+#define BMATRIX_MAXSIZE 8
+
+// Time for the row inputs to be pulled back up after a column is released
+#ifndef BMATRIX_SETTLE_US
+#define BMATRIX_SETTLE_US 3
+#endif
+
 typedef void(*SHButtonMatrixChanged) (int, byte);
 
+// Columns are driven low one at a time, rows are read with their pull ups.
+// Each scan keeps the pressed rows of every column, any number of keys can be held.
+// A key change is reported once seen in two consecutive scans.
 class SHButtonMatrix {
 
 private:
 
-	FastDigitalPin button;
-	uint8_t buttonState;
-	int lastPressedButton;
-	unsigned long buttonLastStateChanged;
-
 	SHButtonMatrixChanged shButtonChangedCallback;
 	SHDebouncer debouncer;
 
 	byte rowCount;
 	byte colCount;
-	byte * colPins;
-	byte * rowPins; 
+	FastDigitalPin colPins[BMATRIX_MAXSIZE];
+	FastDigitalPin rowPins[BMATRIX_MAXSIZE];
+
+	// Pressed rows bitmask per column
+	byte lastScan[BMATRIX_MAXSIZE];
+	byte reported[BMATRIX_MAXSIZE];
+
+	// Without diodes, 3 keys at the corners of a rectangle make the 4th one appear pressed
+	bool ghostDetection;
+
+	void scan(byte * pressed) {
+		for (byte colIndex = 0; colIndex < colCount; colIndex++) {
+			colPins[colIndex].driveLow(true);
+			delayMicroseconds(BMATRIX_SETTLE_US);
+
+			byte rows = 0;
+			for (byte rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+				if (rowPins[rowIndex].digitalRead() == LOW) {
+					rows |= 1 << rowIndex;
+				}
+			}
+			pressed[colIndex] = rows;
+
+			colPins[colIndex].driveLow(false);
+		}
+	}
+
+	static byte bitCount(byte value) {
+		byte count = 0;
+		while (value) {
+			value &= value - 1;
+			count++;
+		}
+		return count;
+	}
+
+	// Columns sharing two or more pressed rows can't be told apart from a ghost, they keep their reported state
+	void maskGhosts(byte * pressed) {
+		byte ghostColumns = 0;
+		for (byte i = 0; i < colCount; i++) {
+			for (byte j = i + 1; j < colCount; j++) {
+				if (bitCount(pressed[i] & pressed[j]) >= 2) {
+					ghostColumns |= (1 << i) | (1 << j);
+				}
+			}
+		}
+
+		for (byte i = 0; i < colCount; i++) {
+			if (ghostColumns & (1 << i)) {
+				pressed[i] = reported[i];
+			}
+		}
+	}
+
 public:
 
-	void begin(byte cols, byte rows, byte * col, byte * row, SHButtonMatrixChanged changedcallback) {
+	void begin(byte cols, byte rows, byte * col, byte * row, bool detectGhosts, SHButtonMatrixChanged changedcallback) {
 
 		debouncer.begin(10);
-		rowCount = rows;
-		colCount = cols;
-		colPins = col;
-		rowPins = row;
+		rowCount = rows < BMATRIX_MAXSIZE ? rows : BMATRIX_MAXSIZE;
+		colCount = cols < BMATRIX_MAXSIZE ? cols : BMATRIX_MAXSIZE;
+		ghostDetection = detectGhosts;
 
 		for (int x = 0; x < rowCount; x++) {
-
-			pinMode(rowPins[x], INPUT);
+			pinMode(row[x], INPUT_PULLUP);
+			rowPins[x].begin(row[x]);
 		}
 
 		for (int x = 0; x < colCount; x++) {
-
-			pinMode(colPins[x], INPUT_PULLUP);
+			colPins[x].begin(col[x]);
+			colPins[x].driveLow(false);
 		}
 
+		memset(lastScan, 0, sizeof(lastScan));
+		memset(reported, 0, sizeof(reported));
+
 		shButtonChangedCallback = changedcallback;
 	}
 
 	void read() {
-		if (debouncer.Debounce()) {
-			int pressedButton = -1;
-			if (buttonLastStateChanged - millis() > 50) {
-				for (int colIndex = 0; colIndex < colCount; colIndex++) {
-
-					byte curCol = colPins[colIndex];
-					pinMode(curCol, OUTPUT);
-					digitalWrite(curCol, LOW);
-
-					for (int rowIndex = 0; rowIndex < rowCount; rowIndex++) {
-						byte rowCol = rowPins[rowIndex];
-						pinMode(rowCol, INPUT_PULLUP);
-						if (digitalRead(rowCol) == LOW) {
-							pressedButton = rowIndex * colCount + colIndex + 1;
-						}
-						//pinMode(rowCol, INPUT);
-					}
-
-					pinMode(curCol, INPUT);
-				}
+		if (!debouncer.Debounce())
+			return;
+
+		byte pressed[BMATRIX_MAXSIZE];
+		scan(pressed);
+
+		for (byte colIndex = 0; colIndex < colCount; colIndex++) {
+			// Keys which changed since the previous scan keep their reported state
+			byte current = pressed[colIndex];
+			byte unstable = current ^ lastScan[colIndex];
+			pressed[colIndex] = (current & ~unstable) | (reported[colIndex] & unstable);
+			lastScan[colIndex] = current;
+		}
+
+		if (ghostDetection) {
+			maskGhosts(pressed);
+		}
 
-				if (pressedButton != lastPressedButton) {
+		for (byte colIndex = 0; colIndex < colCount; colIndex++) {
+			byte changed = pressed[colIndex] ^ reported[colIndex];
+			if (!changed)
+				continue;
 
-					if (lastPressedButton != -1) {
-						shButtonChangedCallback(lastPressedButton, 0);
-					}
-					if (pressedButton != -1) {
-						shButtonChangedCallback(pressedButton, 1);
-					}
-					buttonLastStateChanged = millis();
+			for (byte rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+				byte mask = 1 << rowIndex;
+				if (changed & mask) {
+					shButtonChangedCallback(rowIndex * colCount + colIndex + 1, (pressed[colIndex] & mask) ? 1 : 0);
 				}
-
-				lastPressedButton = pressedButton;
 			}
-			//String s = String(lastPressedButton);
-			//FlowSerialDebugPrintLn(s);
+			reported[colIndex] = pressed[colIndex];
 		}
-
-		return;
-
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
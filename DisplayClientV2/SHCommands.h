@@ -12,7 +12,7 @@ void Command_SetBaudrate() {
 }
 
 void Command_ButtonsCount() {
-	FlowSerialWrite((byte)(ENABLED_BUTTONS_COUNT + ENABLED_BUTTONMATRIX * (BMATRIX_COLS * BMATRIX_ROWS)));
+	FlowSerialWrite((byte)(ENABLED_BUTTONS_COUNT + ENABLED_BUTTONMATRIX * (BMATRIX_COLS * BMATRIX_ROWS) + ENABLED_74HC165_CHIPS * 8));
 	FlowSerialFlush();
 }
 
@@ -44,6 +44,65 @@ void Command_MCUType() {
 	FlowSerialFlush();
 }
 
+// 1 : input events sent as batch packets (0x05), 0 : one packet per event
+void Command_InputEventsMode() {
+	inputEvents.setBatched(FlowSerialTimedRead() == 1);
+}
+
+// Interval between two axes packets (ms), 0 disables them
+void Command_AnalogAxesPacket() {
+	uint8_t interval = FlowSerialTimedRead();
+#ifdef INCLUDE_ANALOGAXES
+	analogAxes.setPacketInterval(interval);
+#endif
+}
+
+// Axis index, released and fully pressed values (uint16, 10 bits), deadzones (percent), curve points
+void Command_AnalogAxisCalibration() {
+	uint8_t axis = FlowSerialTimedRead();
+	uint16_t min = FlowSerialTimedRead();
+	min |= FlowSerialTimedRead() << 8;
+	uint16_t max = FlowSerialTimedRead();
+	max |= FlowSerialTimedRead() << 8;
+	uint8_t deadzoneLow = FlowSerialTimedRead();
+	uint8_t deadzoneHigh = FlowSerialTimedRead();
+	uint8_t curve[5];
+	for (uint8_t i = 0; i < 5; i++) {
+		curve[i] = FlowSerialTimedRead();
+	}
+#ifdef INCLUDE_ANALOGAXES
+	analogAxes.setCalibration(axis, min, max, deadzoneLow, deadzoneHigh, curve);
+#endif
+}
+
+// 1 : accelerated deltas once per ENCODERS_REPORT_MS, 0 : one event per detent
+void Command_EncoderDeltasMode() {
+	uint8_t mode = FlowSerialTimedRead();
+#ifdef INCLUDE_ENCODERS
+	encodersReportDeltas = mode == 1;
+#endif
+}
+
+// Slot, motor (0xFF for all), waveform, frequency, amplitude, attack, decay, sustain, release, duration
+void Command_HapticEffect() {
+#ifdef INCLUDE_HAPTICS
+	haptics.readEffect();
+#else
+	for (uint8_t i = 0; i < 16; i++) {
+		FlowSerialTimedRead();
+	}
+#endif
+}
+
+// Slot, 0xFF for all
+void Command_HapticStop() {
+#ifdef INCLUDE_HAPTICS
+	haptics.readStop();
+#else
+	FlowSerialTimedRead();
+#endif
+}
+
 void Command_EncodersCount() {
 #ifdef INCLUDE_ENCODERS
 	FlowSerialWrite(ENABLED_ENCODERS_COUNT);
@@ -124,6 +183,28 @@ void Command_ExpandedCommandsList() {
 #endif
 #ifdef INCLUDE_ENCODERS
 	FlowSerialPrintLn("encoders");
+	FlowSerialPrintLn("encoderdeltas");
+#endif
+#ifdef INCLUDE_I2CLCD
+	FlowSerialPrintLn("lcdwidget");
+#endif
+#ifdef INCLUDE_TM1637
+	FlowSerialPrintLn("tm1637");
+#endif
+#if defined(INCLUDE_TM1637) || defined(INCLUDE_TM1638) || defined(INCLUDE_MAX7221_MODULES) || defined(INCLUDE_LEDBACKPACK)
+	FlowSerialPrintLn("segvalues");
+#endif
+#if defined(INCLUDE_74HC595_GEAR_DISPLAY) || defined(INCLUDE_6c595_GEAR_DISPLAY)
+	FlowSerialPrintLn("geardigits");
+#endif
+	FlowSerialPrintLn("inputevents");
+#ifdef INCLUDE_ANALOGAXES
+	FlowSerialPrintLn("analogaxes");
+	FlowSerialPrintLn("axiscalibration");
+#endif
+#ifdef INCLUDE_HAPTICS
+	FlowSerialPrintLn("haptic");
+	FlowSerialPrintLn("hapticstop");
 #endif
 	FlowSerialPrintLn("mcutype");
 	FlowSerialPrintLn();
@@ -236,6 +317,9 @@ void Command_Motors() {
 #endif
 #ifdef INCLUDE_SHAKEITPWM
 		shShakeitPWM.read();
+#endif
+#ifdef INCLUDE_HAPTICS
+		haptics.keepAlive();
 #endif
 	}
 #endif
@@ -246,8 +330,8 @@ void Command_7SegmentsData() {
 	// TM1637
 	for (int j = 0; j < TM1637_ENABLEDMODULES; j++) {
 		// Intensity
-		TM1637_screens[j]->set(FlowSerialTimedRead());
-		TM1637_SetDisplayFromSerial(TM1637_screens[j]);
+		byte brightness = FlowSerialTimedRead();
+		TM1637_SetDisplayFromSerial(TM1637_screens[j], brightness);
 	}
 #endif
 	// MAX7221
@@ -266,6 +350,43 @@ void Command_7SegmentsData() {
 #endif
 }
 
+// Formatted values, see SegmentFormat_Read : TM1637 modules, MAX7221 modules,
+// HT16K33 7 segments then TM1638 modules. Intensities are kept from the raw frames.
+void Command_7SegmentsValues() {
+	byte digits[8];
+#ifdef INCLUDE_TM1637
+	for (int j = 0; j < TM1637_ENABLEDMODULES; j++) {
+		if (SegmentFormat_Read(digits, 4))
+			TM1637_screens[j]->writeDigits(digits);
+	}
+#endif
+#ifdef INCLUDE_MAX7221_MODULES
+	for (int j = 0; j < shMAX72217Segment.getDeviceCount(); j++) {
+		if (SegmentFormat_Read(digits, 8))
+			shMAX72217Segment.setDigits(j, digits);
+	}
+	shMAX72217Segment.flushDigits();
+#endif
+#ifdef INCLUDE_LEDBACKPACK
+	for (int j = 0; j < ENABLE_ADA_HT16K33_7SEGMENTS; j++) {
+		if (SegmentFormat_Read(digits, 4))
+			ADA7SEG_SetDigits(digits);
+	}
+#endif
+#ifdef INCLUDE_TM1638
+	for (int j = 0; j < TM1638_ENABLEDMODULES; j++) {
+		if (SegmentFormat_Read(digits, 8))
+			TM1638_screens[j]->Screen->writeDigits(digits);
+	}
+#endif
+}
+
+void Command_TM1637CompactData() {
+#ifdef INCLUDE_TM1637
+	TM1637_ReadCompactFrame();
+#endif
+}
+
 void Command_RGBLEDSCount() {
 	FlowSerialWrite((byte)(WS2812B_RGBLEDCOUNT + PL9823_RGBLEDCOUNT + WS2801_RGBLEDCOUNT));
 	FlowSerialFlush();
@@ -329,13 +450,45 @@ void Command_GearData() {
 
 #ifdef INCLUDE_74HC595_GEAR_DISPLAY
 	if (ENABLE_74HC595_GEAR_DISPLAY == 1) {
-		RS_74HC595_SetChar(gear);
+		RS_74HC595.setChar(0, gear);
+		RS_74HC595.update();
 	}
 #endif
 
 #ifdef INCLUDE_6c595_GEAR_DISPLAY
 	if (ENABLE_6C595_GEAR_DISPLAY == 1) {
-		RS_6c595_SetChar(gear);
+		RS_6c595.setChar(0, gear);
+		RS_6c595.update();
+	}
+#endif
+}
+
+// Chained gear display digits : count, then count chars from the first digit (gear)
+void Command_GearDigits() {
+	byte count = FlowSerialTimedRead();
+
+	for (byte i = 0; i < count; i++) {
+		char c = FlowSerialTimedRead();
+#ifdef INCLUDE_74HC595_GEAR_DISPLAY
+		if (ENABLE_74HC595_GEAR_DISPLAY == 1) {
+			RS_74HC595.setChar(i, c);
+		}
+#endif
+#ifdef INCLUDE_6c595_GEAR_DISPLAY
+		if (ENABLE_6C595_GEAR_DISPLAY == 1) {
+			RS_6c595.setChar(i, c);
+		}
+#endif
+	}
+
+#ifdef INCLUDE_74HC595_GEAR_DISPLAY
+	if (ENABLE_74HC595_GEAR_DISPLAY == 1) {
+		RS_74HC595.update();
+	}
+#endif
+#ifdef INCLUDE_6c595_GEAR_DISPLAY
+	if (ENABLE_6C595_GEAR_DISPLAY == 1) {
+		RS_6c595.update();
 	}
 #endif
 }
@@ -346,6 +499,12 @@ void Command_I2CLCDData() {
 #endif
 }
 
+void Command_I2CLCDWidgets() {
+#ifdef INCLUDE_I2CLCD
+	shI2CLcd.readWidgets();
+#endif
+}
+
 void Command_CustomProtocolData() {
 	shCustomProtocol.read();
 	FlowSerialWrite(0x15);
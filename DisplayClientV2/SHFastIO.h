@@ -28,6 +28,127 @@ public:
 		if (*portInputRegister(port) & bit) return HIGH;
 		return LOW;
 	}
+
+	void digitalWrite(bool value)
+	{
+		uint8_t oldSREG = SREG;
+		cli();
+		if (value)
+			*portOutputRegister(port) |= bit;
+		else
+			*portOutputRegister(port) &= ~bit;
+		SREG = oldSREG;
+	}
+
+	// Open drain output : driven low, or released as a high impedance input without pull up
+	void driveLow(bool low)
+	{
+		uint8_t oldSREG = SREG;
+		cli();
+		*portOutputRegister(port) &= ~bit;
+		if (low)
+			*portModeRegister(port) |= bit;
+		else
+			*portModeRegister(port) &= ~bit;
+		SREG = oldSREG;
+	}
 };
 
+
+// Compile time pin : the port registers and bit are resolved by the compiler,
+// each operation is a single sbi/cbi/sbis instruction.
+// Boards without a pin map below fall back to the Arduino functions.
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega32U4__)
+#define FASTPIN_MAPPED
+
+#define FASTPIN_PORT(L) struct FastPort##L { \
+	static volatile uint8_t & out() { return PORT##L; } \
+	static volatile uint8_t & dir() { return DDR##L; } \
+	static volatile uint8_t & in() { return PIN##L; } \
+};
+
+#define FASTPIN_MAP(PIN, L, BIT) template <> struct FastPinMap<PIN> { \
+	typedef FastPort##L Port; \
+	static const uint8_t mask = 1 << BIT; \
+};
+
+template <uint8_t PIN> struct FastPinMap;
+
+FASTPIN_PORT(B)
+FASTPIN_PORT(C)
+FASTPIN_PORT(D)
+
+#if defined(__AVR_ATmega32U4__)
+// Leonardo / Micro
+FASTPIN_PORT(E)
+FASTPIN_PORT(F)
+FASTPIN_MAP(0, D, 2) FASTPIN_MAP(1, D, 3) FASTPIN_MAP(2, D, 1) FASTPIN_MAP(3, D, 0)
+FASTPIN_MAP(4, D, 4) FASTPIN_MAP(5, C, 6) FASTPIN_MAP(6, D, 7) FASTPIN_MAP(7, E, 6)
+FASTPIN_MAP(8, B, 4) FASTPIN_MAP(9, B, 5) FASTPIN_MAP(10, B, 6) FASTPIN_MAP(11, B, 7)
+FASTPIN_MAP(12, D, 6) FASTPIN_MAP(13, C, 7) FASTPIN_MAP(14, B, 3) FASTPIN_MAP(15, B, 1)
+FASTPIN_MAP(16, B, 2) FASTPIN_MAP(17, B, 0) FASTPIN_MAP(18, F, 7) FASTPIN_MAP(19, F, 6)
+FASTPIN_MAP(20, F, 5) FASTPIN_MAP(21, F, 4) FASTPIN_MAP(22, F, 1) FASTPIN_MAP(23, F, 0)
+#else
+// Uno / Nano / Pro mini
+FASTPIN_MAP(0, D, 0) FASTPIN_MAP(1, D, 1) FASTPIN_MAP(2, D, 2) FASTPIN_MAP(3, D, 3)
+FASTPIN_MAP(4, D, 4) FASTPIN_MAP(5, D, 5) FASTPIN_MAP(6, D, 6) FASTPIN_MAP(7, D, 7)
+FASTPIN_MAP(8, B, 0) FASTPIN_MAP(9, B, 1) FASTPIN_MAP(10, B, 2) FASTPIN_MAP(11, B, 3)
+FASTPIN_MAP(12, B, 4) FASTPIN_MAP(13, B, 5) FASTPIN_MAP(14, C, 0) FASTPIN_MAP(15, C, 1)
+FASTPIN_MAP(16, C, 2) FASTPIN_MAP(17, C, 3) FASTPIN_MAP(18, C, 4) FASTPIN_MAP(19, C, 5)
+#endif
+
+template <uint8_t PIN>
+class FastPin {
+private:
+	typedef typename FastPinMap<PIN>::Port Port;
+	static const uint8_t mask = FastPinMap<PIN>::mask;
+
+public:
+	static void high() { Port::out() |= mask; }
+	static void low() { Port::out() &= ~mask; }
+	static void write(bool value) { if (value) high(); else low(); }
+	// Writing a 1 to the input register toggles the output
+	static void toggle() { Port::in() = mask; }
+	static bool read() { return Port::in() & mask; }
+
+	static void mode(uint8_t pinMode) {
+		if (pinMode == OUTPUT) {
+			Port::dir() |= mask;
+		}
+		else {
+			Port::dir() &= ~mask;
+			write(pinMode == INPUT_PULLUP);
+		}
+	}
+};
+
+#else
+
+template <uint8_t PIN>
+class FastPin {
+public:
+	static void high() { digitalWrite(PIN, HIGH); }
+	static void low() { digitalWrite(PIN, LOW); }
+	static void write(bool value) { digitalWrite(PIN, value ? HIGH : LOW); }
+	static void toggle() { digitalWrite(PIN, !digitalRead(PIN)); }
+	static bool read() { return digitalRead(PIN) == HIGH; }
+	static void mode(uint8_t pinMode) { ::pinMode(PIN, pinMode); }
+};
+
+#endif
+
+// shiftOut on compile time pins
+template <uint8_t DATAPIN, uint8_t CLOCKPIN>
+void fastShiftOut(uint8_t bitOrder, uint8_t value) {
+	for (uint8_t i = 0; i < 8; i++) {
+		if (bitOrder == LSBFIRST)
+			FastPin<DATAPIN>::write(value & (1 << i));
+		else
+			FastPin<DATAPIN>::write(value & (0x80 >> i));
+
+		FastPin<CLOCKPIN>::high();
+		FastPin<CLOCKPIN>::low();
+	}
+}
+
 #endif
\ No newline at end of file
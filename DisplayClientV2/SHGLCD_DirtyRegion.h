@@ -0,0 +1,128 @@
+#ifndef __SHGLCD_DIRTYREGION_H__
+#define __SHGLCD_DIRTYREGION_H__
+
+#include <Arduino.h>
+#include "Adafruit_GFX.h"
+
+#define GLCD_DIRTY_MAXPAGES 8
+
+// Wraps a page based monochrome display (SSD1306, PCD8544) and records
+// for each 8 pixels high page the columns touched by drawing calls.
+// Drawing calls are converted to controller coordinates, so the recorded
+// ranges can be flushed directly with the controller page/column addressing.
+template <class TDisplay>
+class SHGLCDDirtyRegion : public TDisplay {
+private:
+	// Columns touched since last flush, min > max when the page is clean
+	uint8_t dirtyMin[GLCD_DIRTY_MAXPAGES];
+	uint8_t dirtyMax[GLCD_DIRTY_MAXPAGES];
+
+	// Columns drawn since last clear, they must be flushed after the next clear
+	uint8_t drawnMin[GLCD_DIRTY_MAXPAGES];
+	uint8_t drawnMax[GLCD_DIRTY_MAXPAGES];
+
+	void resetRanges(uint8_t * minCols, uint8_t * maxCols) {
+		for (int p = 0; p < GLCD_DIRTY_MAXPAGES; p++) {
+			minCols[p] = 255;
+			maxCols[p] = 0;
+		}
+	}
+
+	void markPhysical(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+		if (x0 > x1) { int16_t t = x0; x0 = x1; x1 = t; }
+		if (y0 > y1) { int16_t t = y0; y0 = y1; y1 = t; }
+
+		if (x1 < 0 || y1 < 0 || x0 >= this->WIDTH || y0 >= this->HEIGHT)
+			return;
+
+		if (x0 < 0) x0 = 0;
+		if (y0 < 0) y0 = 0;
+		if (x1 >= this->WIDTH) x1 = this->WIDTH - 1;
+		if (y1 >= this->HEIGHT) y1 = this->HEIGHT - 1;
+
+		for (int p = y0 >> 3; p <= (y1 >> 3) && p < GLCD_DIRTY_MAXPAGES; p++) {
+			if (x0 < dirtyMin[p]) dirtyMin[p] = x0;
+			if (x1 > dirtyMax[p]) dirtyMax[p] = x1;
+			if (x0 < drawnMin[p]) drawnMin[p] = x0;
+			if (x1 > drawnMax[p]) drawnMax[p] = x1;
+		}
+	}
+
+	// Rectangle in rotated (user) coordinates
+	void markLogical(int16_t x, int16_t y, int16_t w, int16_t h) {
+		if (w <= 0 || h <= 0)
+			return;
+
+		int16_t x1 = x + w - 1;
+		int16_t y1 = y + h - 1;
+
+		switch (this->getRotation()) {
+		case 1:
+			markPhysical(this->WIDTH - 1 - y, x, this->WIDTH - 1 - y1, x1);
+			break;
+		case 2:
+			markPhysical(this->WIDTH - 1 - x, this->HEIGHT - 1 - y, this->WIDTH - 1 - x1, this->HEIGHT - 1 - y1);
+			break;
+		case 3:
+			markPhysical(y, this->HEIGHT - 1 - x, y1, this->HEIGHT - 1 - x1);
+			break;
+		default:
+			markPhysical(x, y, x1, y1);
+			break;
+		}
+	}
+
+public:
+
+	template <typename... Args>
+	SHGLCDDirtyRegion(Args... args) : TDisplay(args...) {
+		resetRanges(dirtyMin, dirtyMax);
+		resetRanges(drawnMin, drawnMax);
+	}
+
+	void drawPixel(int16_t x, int16_t y, uint16_t color) {
+		markLogical(x, y, 1, 1);
+		TDisplay::drawPixel(x, y, color);
+	}
+
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+		markLogical(x, y, w, 1);
+		TDisplay::drawFastHLine(x, y, w, color);
+	}
+
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+		markLogical(x, y, 1, h);
+		TDisplay::drawFastVLine(x, y, h, color);
+	}
+
+	// Only the area drawn since the previous clear has to be sent again,
+	// the rest of the screen is already blank on the controller side.
+	void clearDisplay() {
+		TDisplay::clearDisplay();
+		for (int p = 0; p < GLCD_DIRTY_MAXPAGES; p++) {
+			if (drawnMin[p] < dirtyMin[p]) dirtyMin[p] = drawnMin[p];
+			if (drawnMax[p] > dirtyMax[p]) dirtyMax[p] = drawnMax[p];
+		}
+		resetRanges(drawnMin, drawnMax);
+	}
+
+	bool getDirtyColumns(uint8_t page, uint8_t & minCol, uint8_t & maxCol) {
+		if (page >= GLCD_DIRTY_MAXPAGES || dirtyMin[page] > dirtyMax[page])
+			return false;
+		minCol = dirtyMin[page];
+		maxCol = dirtyMax[page];
+		return true;
+	}
+
+	uint8_t getPageCount() {
+		uint8_t pages = this->HEIGHT / 8;
+		return pages < GLCD_DIRTY_MAXPAGES ? pages : GLCD_DIRTY_MAXPAGES;
+	}
+
+	// To be called once the dirty ranges (or the full buffer) have been sent
+	void markClean() {
+		resetRanges(dirtyMin, dirtyMax);
+	}
+};
+
+#endif
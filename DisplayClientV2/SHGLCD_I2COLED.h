@@ -2,22 +2,68 @@
 #define __SHGLCD_I2COLED_H__
 
 #include <Arduino.h>
+#include <Wire.h>
 #include "Adafruit_GFX.h"
 #include <Adafruit_SSD1306.h>
+#include "SHGLCD_DirtyRegion.h"
+#include "SHI2CQueue.h"
 #include "SHGLCD_base.h"
 
 
 #define OLED_RESET 4
+#define OLED_I2CADDRESS 0x3C
 
-Adafruit_SSD1306 glcd1(OLED_RESET);
-Adafruit_SSD1306 * oled[] = { &glcd1 };
+// SSD1306 sending only the touched columns of each page instead of the whole 1KB buffer.
+// Small updates fit in the I2C queue and return immediately, a full frame waits for the queue.
+// The pages are not spread over idle() calls, the host may draw the next frame in the meantime.
+class SHSSD1306 : public SHGLCDDirtyRegion<Adafruit_SSD1306> {
+public:
+	SHSSD1306(int8_t resetPin) : SHGLCDDirtyRegion<Adafruit_SSD1306>(resetPin) {
+	}
+
+	void displayDirty() {
+		uint8_t * buffer = getBuffer();
+		uint8_t minCol, maxCol;
+
+		for (uint8_t page = 0; page < getPageCount(); page++) {
+			if (!getDirtyColumns(page, minCol, maxCol))
+				continue;
+
+			// Command stream
+			i2cQueue.beginWrite(I2CQUEUE_PRIORITY_NORMAL, OLED_I2CADDRESS, 7, true);
+			i2cQueue.write((uint8_t)0x00);
+			i2cQueue.write((uint8_t)SSD1306_PAGEADDR);
+			i2cQueue.write(page);
+			i2cQueue.write(page);
+			i2cQueue.write((uint8_t)SSD1306_COLUMNADDR);
+			i2cQueue.write(minCol);
+			i2cQueue.write(maxCol);
+
+			uint8_t * data = buffer + page * WIDTH + minCol;
+			uint16_t count = maxCol - minCol + 1;
+			while (count > 0) {
+				// Wire buffer is 32 bytes including the control byte
+				uint8_t chunk = count > 31 ? 31 : count;
+				i2cQueue.beginWrite(I2CQUEUE_PRIORITY_NORMAL, OLED_I2CADDRESS, chunk + 1, true);
+				i2cQueue.write((uint8_t)0x40);
+				i2cQueue.write(data, chunk);
+				data += chunk;
+				count -= chunk;
+			}
+		}
+		markClean();
+	}
+};
+
+SHSSD1306 glcd1(OLED_RESET);
+SHSSD1306 * oled[] = { &glcd1 };
 
 class SHGLCD_I2COLED : public SHGLCD_Base
 {
 public:
 
 	void Init() {
-		glcd1.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+		glcd1.begin(SSD1306_SWITCHCAPVCC, OLED_I2CADDRESS);
 		glcd1.clearDisplay();
 		glcd1.setFont();
 		glcd1.setTextSize(2);
@@ -25,10 +71,11 @@ public:
 		glcd1.setCursor(30, 20);
 		glcd1.print("SimHub");
 		glcd1.display();
+		glcd1.markClean();
 	}
 
 	void Display(int idx) {
-		oled[idx]->display();
+		oled[idx]->displayDirty();
 	}
 
 	void ClearDisplay(int idx) {
@@ -48,4 +95,4 @@ public:
 	}
 
 };
-#endif
\ No newline at end of file
+#endif
@@ -4,12 +4,32 @@
 #include <Arduino.h>
 #include "Adafruit_GFX.h"
 #include <Adafruit_PCD8544.h>
+#include "SHGLCD_DirtyRegion.h"
 #include "SHGLCD_base.h"
 
+// PCD8544 only flushed when something was drawn since the last flush.
+// The frame buffer is internal to the Adafruit library, the flush itself goes through display().
+class SHPCD8544 : public SHGLCDDirtyRegion<Adafruit_PCD8544> {
+public:
+	SHPCD8544(int8_t sclk, int8_t din, int8_t dc, int8_t cs, int8_t rst) : SHGLCDDirtyRegion<Adafruit_PCD8544>(sclk, din, dc, cs, rst) {
+	}
+
+	void displayDirty() {
+		uint8_t minCol, maxCol;
+
+		for (uint8_t page = 0; page < getPageCount(); page++) {
+			if (getDirtyColumns(page, minCol, maxCol)) {
+				display();
+				break;
+			}
+		}
+		markClean();
+	}
+};
 
 // Adafruit_PCD8544 display = Adafruit_PCD8544(SCLK, DIN, DC, CS or SCE, RST);
-Adafruit_PCD8544 nokia1 = Adafruit_PCD8544(A0, A1, A2, A4, A3);
-Adafruit_PCD8544 * nokia[] = { &nokia1 };
+SHPCD8544 nokia1 = SHPCD8544(A0, A1, A2, A4, A3);
+SHPCD8544 * nokia[] = { &nokia1 };
 
 class SHGLCD_NOKIA : public SHGLCD_Base
 {
@@ -28,11 +48,12 @@ public:
 		nokia1.print("Hello");
 
 		nokia1.display();
+		nokia1.markClean();
 		nokia1.setCursor(0, 20);
 	}
 
 	void Display(int idx) {
-		nokia[idx]->display();
+		nokia[idx]->displayDirty();
 	}
 
 	void ClearDisplay(int idx) {
@@ -52,4 +73,4 @@ public:
 	}
 
 };
-#endif
\ No newline at end of file
+#endif
@@ -10,6 +10,103 @@
 #include "ACHubCustomFonts/Open24DisplaySt18pt7b.h"
 #define CUSTOM_LCD_FONT_2 Open24DisplaySt18pt7b
 
+// Retained layout sizing, can be overridden before including this file.
+// Each item takes 25 bytes and each slot GLCD_LAYOUT_SLOTLENGTH + 1 bytes of RAM
+#ifndef GLCD_LAYOUT_MAXITEMS
+#define GLCD_LAYOUT_MAXITEMS 4
+#endif
+
+#ifndef GLCD_LAYOUT_MAXSLOTS
+#define GLCD_LAYOUT_MAXSLOTS 4
+#endif
+
+#ifndef GLCD_LAYOUT_SLOTLENGTH
+#define GLCD_LAYOUT_SLOTLENGTH 8
+#endif
+
+#if GLCD_LAYOUT_MAXSLOTS > 16
+#error "GLCD_LAYOUT_MAXSLOTS must be 16 or less"
+#endif
+
+#define GLCD_LAYOUT_STATIC 255
+
+// Bitmap cache sizing, can be overridden before including this file.
+// Disabled by default (0), streamed bitmaps are still drawn
+#ifndef GLCD_BITMAP_CACHESIZE
+#define GLCD_BITMAP_CACHESIZE 0
+#endif
+
+#if GLCD_BITMAP_CACHESIZE > 0
+#ifndef GLCD_BITMAP_MAXSLOTS
+#define GLCD_BITMAP_MAXSLOTS 4
+#endif
+#else
+#undef GLCD_BITMAP_MAXSLOTS
+#define GLCD_BITMAP_MAXSLOTS 0
+#endif
+
+// PROGMEM pointer read, same definition as in Adafruit_GFX.cpp
+#if !defined(__INT_MAX__) || (__INT_MAX__ > 0xFFFF)
+#define GLCD_pgm_read_pointer(addr) ((void *)pgm_read_dword(addr))
+#else
+#define GLCD_pgm_read_pointer(addr) ((void *)pgm_read_word(addr))
+#endif
+
+// Bitmap encodings
+#define GLCD_BITMAP_RAW 0
+#define GLCD_BITMAP_PACKBITS 1
+
+// Batch frame trailing flags
+#define GLCD_BATCH_DISPLAY 0x01
+
+// sin(0..90 degrees) in Q14 fixed point, used by needles and arcs
+const int16_t GLCD_SIN_TABLE[91] PROGMEM = {
+	0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563,
+	2845, 3126, 3406, 3686, 3964, 4240, 4516, 4790, 5063, 5334,
+	5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943,
+	8192, 8438, 8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311,
+	10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+	12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+	14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+	15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+	16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+	16384
+};
+
+// One primitive of the retained layout.
+// Text items ('P') are bound to a value slot and redrawn when the slot changes,
+// other primitives are static and only drawn on a full layout redraw.
+struct SHGLCDLayoutItem {
+	char kind;
+	uint8_t screen;
+	uint8_t slot;
+	int16_t x;
+	int16_t y;
+	int16_t w;
+	int16_t h;
+	uint8_t r;
+	uint8_t color;
+	uint8_t textSize;
+	uint8_t fontType;
+	uint8_t wrap;
+	uint8_t align;
+
+	// Area covered by the last drawn text, erased before the next draw
+	int16_t boundX;
+	int16_t boundY;
+	uint16_t boundW;
+	uint16_t boundH;
+};
+
+// 1 bpp bitmap kept compressed in the on device cache, empty when length is 0
+struct SHGLCDBitmapSlot {
+	uint16_t offset;
+	uint16_t length;
+	uint8_t w;
+	uint8_t h;
+	uint8_t encoding;
+};
+
 class SHGLCD_Base
 {
 private:
@@ -35,8 +132,734 @@ private:
 
 	Adafruit_GFX* currentNokia;
 
+	SHGLCDLayoutItem layoutItems[GLCD_LAYOUT_MAXITEMS];
+	uint8_t layoutItemsCount = 0;
+	char layoutSlots[GLCD_LAYOUT_MAXSLOTS][GLCD_LAYOUT_SLOTLENGTH + 1];
+
+#if GLCD_BITMAP_CACHESIZE > 0
+	SHGLCDBitmapSlot bitmapSlots[GLCD_BITMAP_MAXSLOTS];
+	uint8_t bitmapCache[GLCD_BITMAP_CACHESIZE];
+	uint16_t bitmapCacheUsed = 0;
+#endif
+
+	// Compressed bytes left to decode, read from bitmapSource when set, else from serial
+	const uint8_t* bitmapSource;
+	uint16_t bitmapRemaining;
+
+	const GFXfont* getFont(uint8_t font) {
+		if (font == 1) {
+			return &CUSTOM_LCD_FONT_1;
+		}
+		else if (font == 2) {
+			return &CUSTOM_LCD_FONT_2;
+		}
+
+#ifdef CUSTOM_LCD_FONT_3
+		else if (font == 3) {
+			return &CUSTOM_LCD_FONT_3;
+		}
+#endif
+		return 0;
+	}
+
+	void setFont(Adafruit_GFX* screen, uint8_t font) {
+		screen->setFont(getFont(font));
+	}
+
+	// Same result as getTextBounds(content + "\n ") for a single line of text without wrapping :
+	// the box starts at the cursor origin, and glyphs count like in charBounds, even without any ink.
+	// Computed from the glyph metrics stored in the font PROGMEM tables without any allocation
+	void getTextBox(uint8_t font, uint8_t textSize, int16_t x, int16_t y, const char* content, int16_t* bx, int16_t* by, uint16_t* bw, uint16_t* bh) {
+		const GFXfont* gfxFont = getFont(font);
+		int16_t minx = x, miny = 0x7FFF, maxx = x - 1, maxy = -1;
+		int16_t cursorX = x;
+
+		if (gfxFont == 0) {
+			// Classic 5x7 font, 6x8 cell per character
+			uint16_t count = strlen(content);
+			if (count > 0) {
+				miny = y;
+				maxx = x + count * 6 * textSize - 1;
+				maxy = y + 8 * textSize - 1;
+			}
+		}
+		else {
+			// Read as Adafruit_GFX does, first and last are 8 or 16 bits depending on the library version
+			uint8_t first = pgm_read_byte(&gfxFont->first);
+			uint8_t last = pgm_read_byte(&gfxFont->last);
+			GFXglyph* glyphs = (GFXglyph*)GLCD_pgm_read_pointer(&gfxFont->glyph);
+
+			for (const char* c = content; *c; c++) {
+				uint8_t ch = (uint8_t)*c;
+				if (ch < first || ch > last)
+					continue;
+
+				GFXglyph* glyph = glyphs + (ch - first);
+				int16_t x1 = cursorX + (int8_t)pgm_read_byte(&glyph->xOffset) * textSize;
+				int16_t y1 = y + (int8_t)pgm_read_byte(&glyph->yOffset) * textSize;
+				int16_t x2 = x1 + pgm_read_byte(&glyph->width) * textSize - 1;
+				int16_t y2 = y1 + pgm_read_byte(&glyph->height) * textSize - 1;
+				if (x1 < minx) minx = x1;
+				if (y1 < miny) miny = y1;
+				if (x2 > maxx) maxx = x2;
+				if (y2 > maxy) maxy = y2;
+				cursorX += pgm_read_byte(&glyph->xAdvance) * textSize;
+			}
+		}
+
+		if (maxx >= minx) {
+			*bx = minx;
+			*bw = maxx - minx + 1;
+		}
+		else {
+			*bx = x;
+			*bw = 0;
+		}
+
+		if (maxy >= miny) {
+			*by = miny;
+			*bh = maxy - miny + 1;
+		}
+		else {
+			*by = y;
+			*bh = 0;
+		}
+	}
+
+	// Applies the text settings and moves the cursor to the aligned position, returns the aligned X
+	int16_t prepareText(Adafruit_GFX* screen, uint8_t textSize, uint8_t font, int16_t x, int16_t y, uint16_t textColor, bool wrap, uint8_t textAlign, const char* content) {
+		screen->setTextSize(textSize);
+		screen->setTextColor(textColor);
+		screen->setTextWrap(wrap);
+		setFont(screen, font);
+
+		if (textAlign == 2 || textAlign == 3)
+		{
+			getTextBox(font, textSize, 0, 0, content, &boundX, &boundY, &boundW, &boundH);
+			// Empty classic font text still counts as one blank character
+			if (boundW == 0 && getFont(font) == 0) {
+				boundW = 6 * textSize;
+			}
+			x = x - (textAlign == 2 ? boundW / 2 : boundW);
+		}
+
+		screen->setCursor(x, y);
+		return x;
+	}
+
+	static uint16_t isqrt(uint32_t value) {
+		uint32_t result = 0;
+		uint32_t bit = 1UL << 30;
+
+		while (bit > value)
+			bit >>= 2;
+
+		while (bit != 0) {
+			if (value >= result + bit) {
+				value -= result + bit;
+				result = (result >> 1) + bit;
+			}
+			else {
+				result >>= 1;
+			}
+			bit >>= 2;
+		}
+		return (uint16_t)result;
+	}
+
+	// Rounded a * b / c, c > 0
+	static int16_t mulDiv(int32_t a, int32_t b, int32_t c) {
+		int32_t n = a * b;
+		return (int16_t)(n >= 0 ? (n + c / 2) / c : (n - c / 2) / c);
+	}
+
+	// Angle in degrees, result in Q14
+	static int16_t sin14(int16_t angle) {
+		angle %= 360;
+		if (angle < 0)
+			angle += 360;
+
+		if (angle <= 90)
+			return pgm_read_word(&GLCD_SIN_TABLE[angle]);
+		if (angle <= 180)
+			return pgm_read_word(&GLCD_SIN_TABLE[180 - angle]);
+		if (angle <= 270)
+			return -(int16_t)pgm_read_word(&GLCD_SIN_TABLE[angle - 180]);
+		return -(int16_t)pgm_read_word(&GLCD_SIN_TABLE[360 - angle]);
+	}
+
+	static int16_t cos14(int16_t angle) {
+		return sin14(angle + 90);
+	}
+
+	// Point at the given radius, angle 0 is 12 o'clock and angles grow clockwise
+	static void polarPoint(int16_t cx, int16_t cy, int16_t radius, int16_t angle, int16_t& x, int16_t& y) {
+		x = cx + (int16_t)(((int32_t)radius * sin14(angle) + 8192) >> 14);
+		y = cy - (int16_t)(((int32_t)radius * cos14(angle) + 8192) >> 14);
+	}
+
+	void drawThickLine(Adafruit_GFX* screen, int16_t x1, int16_t y1, int16_t x2, int16_t y2, int thickness, uint16_t lineColor) {
+		int32_t dx = (int32_t)x1 - x2;
+		int32_t dy = (int32_t)y1 - y2;
+
+		// Batch coordinates can be far off screen, long lines are scaled down
+		// so the squared length fits in 32 bits
+		while (dx > 0x7FFF || dx < -0x7FFF || dy > 0x7FFF || dy < -0x7FFF) {
+			dx /= 2;
+			dy /= 2;
+		}
+
+		uint32_t ux = dx < 0 ? -dx : dx;
+		uint32_t uy = dy < 0 ? -dy : dy;
+		uint32_t d2 = ux * ux + uy * uy;
+		if (!d2)
+			return;
+
+		// Scale short lines up so the integer length keeps a few fractional bits
+		uint8_t shift = 0;
+		while (d2 < 0x400000UL && shift < 8) {
+			d2 <<= 2;
+			shift++;
+		}
+		int32_t d = isqrt(d2);
+
+		// Normal offsets
+		int16_t ox = mulDiv(thickness, dy << shift, d);
+		int16_t oy = mulDiv(thickness, dx << shift, d);
+
+		screen->fillTriangle(x1 - ox, y1 + oy, x2 - ox, y2 + oy, x1 + ox, y1 - oy, lineColor);
+		screen->fillTriangle(x1 + ox, y1 - oy, x2 + ox, y2 - oy, x2 - ox, y2 + oy, lineColor);
+	}
+
+	// Gauge needle from the inner to the outer radius
+	void drawNeedle(Adafruit_GFX* screen, int16_t cx, int16_t cy, int16_t angle, int16_t innerRadius, int16_t outerRadius, int thickness, uint16_t needleColor) {
+		int16_t x1, y1, x2, y2;
+		polarPoint(cx, cy, innerRadius, angle, x1, y1);
+		polarPoint(cx, cy, outerRadius, angle, x2, y2);
+
+		if (thickness > 0)
+			drawThickLine(screen, x1, y1, x2, y2, thickness, needleColor);
+		else
+			screen->drawLine(x1, y1, x2, y2, needleColor);
+	}
+
+	// Arc from startAngle to endAngle (clockwise), thickness pixels inward from the radius
+	void drawArc(Adafruit_GFX* screen, int16_t cx, int16_t cy, int16_t radius, int thickness, int16_t startAngle, int16_t endAngle, uint16_t arcColor) {
+		if (radius <= 0)
+			return;
+
+		while (endAngle < startAngle)
+			endAngle += 360;
+
+		int16_t innerRadius = thickness > 1 ? radius - thickness + 1 : radius;
+		if (innerRadius < 0)
+			innerRadius = 0;
+
+		// Segments around 4 pixels long on the outer edge
+		int16_t step = 229 / radius;
+		if (step < 1)
+			step = 1;
+
+		int16_t ox0, oy0, ix0, iy0;
+		polarPoint(cx, cy, radius, startAngle, ox0, oy0);
+		polarPoint(cx, cy, innerRadius, startAngle, ix0, iy0);
+
+		for (int16_t angle = startAngle; angle < endAngle;) {
+			angle = endAngle - angle > step ? angle + step : endAngle;
+
+			int16_t ox1, oy1, ix1, iy1;
+			polarPoint(cx, cy, radius, angle, ox1, oy1);
+
+			if (innerRadius == radius) {
+				screen->drawLine(ox0, oy0, ox1, oy1, arcColor);
+			}
+			else {
+				polarPoint(cx, cy, innerRadius, angle, ix1, iy1);
+				screen->fillTriangle(ox0, oy0, ox1, oy1, ix0, iy0, arcColor);
+				screen->fillTriangle(ox1, oy1, ix1, iy1, ix0, iy0, arcColor);
+				ix0 = ix1;
+				iy0 = iy1;
+			}
+			ox0 = ox1;
+			oy0 = oy1;
+		}
+	}
+
+	void drawRect(Adafruit_GFX* screen, bool fill, int16_t x, int16_t y, int16_t rw, int16_t rh, int16_t radius, uint16_t rectColor) {
+		if (radius == 0) {
+			if (fill)
+				screen->fillRect(x, y, rw, rh, rectColor);
+			else
+				screen->drawRect(x, y, rw, rh, rectColor);
+		}
+		else {
+			if (fill)
+				screen->fillRoundRect(x, y, rw, rh, radius, rectColor);
+			else
+				screen->drawRoundRect(x, y, rw, rh, radius, rectColor);
+		}
+	}
+
+	// Reads a string terminated by '\n', characters beyond maxLength are dropped
+	void readBoundedString(char* buffer, uint8_t maxLength) {
+		uint8_t pos = 0;
+		int c = FlowSerialTimedRead();
+		while (c >= 0 && c != '\n') {
+			if (pos < maxLength) {
+				buffer[pos++] = (char)c;
+			}
+			c = FlowSerialTimedRead();
+		}
+		buffer[pos] = 0;
+	}
+
+	void drawLayoutItem(SHGLCDLayoutItem& item) {
+		Adafruit_GFX* screen = GetScreen(item.screen);
+
+		if (item.kind == 'P') {
+			// Erase previous value using the background color
+			if (item.boundW > 0 && item.boundH > 0) {
+				screen->fillRect(item.boundX, item.boundY, item.boundW, item.boundH, item.color ? 0 : 1);
+			}
+
+			const char* content = layoutSlots[item.slot];
+			int16_t x = prepareText(screen, item.textSize, item.fontType, item.x, item.y, item.color, item.wrap > 0, item.align, content);
+			getTextBox(item.fontType, item.textSize, x, item.y, content, &item.boundX, &item.boundY, &item.boundW, &item.boundH);
+			screen->print(content);
+		}
+		else if (item.kind == 'L') {
+			screen->drawLine(item.x, item.y, item.w, item.h, item.color);
+		}
+		else if (item.kind == 'T') {
+			drawThickLine(screen, item.x, item.y, item.w, item.h, item.r, item.color);
+		}
+		else if (item.kind == 'F' || item.kind == 'R') {
+			drawRect(screen, item.kind == 'F', item.x, item.y, item.w, item.h, item.r, item.color);
+		}
+	}
+
+	void clearLayout() {
+		layoutItemsCount = 0;
+		for (int i = 0; i < GLCD_LAYOUT_MAXSLOTS; i++) {
+			layoutSlots[i][0] = 0;
+		}
+	}
+
+	void addLayoutItem() {
+		SHGLCDLayoutItem item;
+		item.kind = FlowSerialTimedRead();
+		item.screen = nokiaIndex;
+		item.slot = FlowSerialTimedRead();
+		item.r = 0;
+		item.boundW = 0;
+		item.boundH = 0;
+
+		if (item.kind == 'P') {
+			item.textSize = FlowSerialTimedRead();
+			item.fontType = FlowSerialTimedRead();
+			item.x = (int16_t)FlowSerialTimedRead();
+			item.y = (int16_t)FlowSerialTimedRead();
+			item.color = FlowSerialTimedRead();
+			item.wrap = FlowSerialTimedRead();
+			item.align = FlowSerialTimedRead();
+		}
+		else if (item.kind == 'L' || item.kind == 'T' || item.kind == 'F' || item.kind == 'R') {
+			item.x = (int16_t)FlowSerialTimedRead();
+			item.y = (int16_t)FlowSerialTimedRead();
+			item.w = (int16_t)FlowSerialTimedRead();
+			item.h = (int16_t)FlowSerialTimedRead();
+			if (item.kind != 'L') {
+				item.r = FlowSerialTimedRead();
+			}
+			item.color = FlowSerialTimedRead();
+		}
+		else {
+			return;
+		}
+
+		// Only text can be bound to a value slot
+		if (item.kind == 'P' && item.slot >= GLCD_LAYOUT_MAXSLOTS) {
+			return;
+		}
+
+		if (layoutItemsCount < GLCD_LAYOUT_MAXITEMS) {
+			layoutItems[layoutItemsCount++] = item;
+		}
+	}
+
+	void redrawLayout() {
+		for (int i = 0; i < layoutItemsCount; i++) {
+			if (layoutItems[i].screen == nokiaIndex) {
+				layoutItems[i].boundW = 0;
+				drawLayoutItem(layoutItems[i]);
+			}
+		}
+		Display(nokiaIndex);
+	}
+
+	void readLayoutSlots() {
+		char value[GLCD_LAYOUT_SLOTLENGTH + 1];
+		uint16_t changedSlots = 0;
+		uint8_t changedScreens = 0;
+
+		uint8_t count = FlowSerialTimedRead();
+		for (int i = 0; i < count; i++) {
+			uint8_t slot = FlowSerialTimedRead();
+			readBoundedString(value, GLCD_LAYOUT_SLOTLENGTH);
+
+			if (slot < GLCD_LAYOUT_MAXSLOTS && strcmp(value, layoutSlots[slot]) != 0) {
+				strcpy(layoutSlots[slot], value);
+				changedSlots |= (1 << slot);
+			}
+		}
+
+		if (changedSlots == 0)
+			return;
+
+		for (int i = 0; i < layoutItemsCount; i++) {
+			SHGLCDLayoutItem& item = layoutItems[i];
+			if (item.kind == 'P' && (changedSlots & (1 << item.slot))) {
+				drawLayoutItem(item);
+				changedScreens |= (1 << item.screen);
+			}
+		}
+
+		for (int i = 0; i < GetScreenCount(); i++) {
+			if (changedScreens & (1 << i)) {
+				Display(i);
+			}
+		}
+	}
+
+	int16_t readInt16() {
+		uint8_t lo = FlowSerialTimedRead();
+		uint8_t hi = FlowSerialTimedRead();
+		return (int16_t)(lo | (hi << 8));
+	}
+
+	// Batch frame : primitives with 16 bits little endian coordinates, terminated by 0 and a flags byte
+	// 'C'
+	// 'P' size, font, x, y, color, wrap, align, text '\n'
+	// 'L' x1, y1, x2, y2, color
+	// 'T' x1, y1, x2, y2, thickness, color
+	// 'F'/'R' x, y, w, h, radius, color
+	// 'G' cx, cy, angle, inner radius, outer radius, thickness, color
+	// 'A' cx, cy, radius, start angle, end angle, thickness, color
+	// 'M' bitmap sub command, see readBitmap
+	void readBatch() {
+		int kind = FlowSerialTimedRead();
+		while (kind > 0) {
+			if (kind == 'C') {
+				ClearDisplay(nokiaIndex);
+			}
+			else if (kind == 'P') {
+				uint8_t textSize = FlowSerialTimedRead();
+				fontType = FlowSerialTimedRead();
+				posX = readInt16();
+				posY = readInt16();
+				color = FlowSerialTimedRead();
+				bool wrap = FlowSerialTimedRead() > 0;
+				align = FlowSerialTimedRead();
+
+				String content = FlowSerialReadStringUntil('\n');
+
+				prepareText(currentNokia, textSize, fontType, posX, posY, color, wrap, align, content.c_str());
+				currentNokia->print(content);
+			}
+			else if (kind == 'L' || kind == 'T') {
+				posX = readInt16();
+				posY = readInt16();
+				w = readInt16(); // x2
+				h = readInt16(); // y2
+				int thickness = kind == 'T' ? FlowSerialTimedRead() : 0;
+				color = FlowSerialTimedRead();
+
+				if (kind == 'L')
+					currentNokia->drawLine(posX, posY, w, h, color);
+				else
+					drawThickLine(currentNokia, posX, posY, w, h, thickness, color);
+			}
+			else if (kind == 'F' || kind == 'R') {
+				posX = readInt16();
+				posY = readInt16();
+				w = readInt16();
+				h = readInt16();
+				r = FlowSerialTimedRead();
+				color = FlowSerialTimedRead();
+
+				drawRect(currentNokia, kind == 'F', posX, posY, w, h, r, color);
+			}
+			else if (kind == 'G' || kind == 'A') {
+				readArcParams(kind);
+			}
+			else if (kind == 'M') {
+				readBitmap();
+			}
+			else {
+				// Unknown primitive, the rest of the frame can't be decoded
+				return;
+			}
+
+			kind = FlowSerialTimedRead();
+		}
+
+		if (kind < 0)
+			return;
+
+		uint8_t flags = FlowSerialTimedRead();
+		if (flags & GLCD_BATCH_DISPLAY) {
+			Display(nokiaIndex);
+		}
+	}
+
+	int readBitmapByte() {
+		if (bitmapRemaining == 0)
+			return -1;
+		bitmapRemaining--;
+		if (bitmapSource)
+			return *bitmapSource++;
+		return FlowSerialTimedRead();
+	}
+
+	// Decodes a 1 bpp bitmap (rows MSB first, padded to a byte as for drawBitmap),
+	// set pixels are drawn as horizontal runs, clear pixels are left untouched
+	void drawBitmap(Adafruit_GFX* screen, int16_t x, int16_t y, uint8_t bw, uint8_t bh, uint8_t encoding, uint16_t bitmapColor) {
+		uint8_t stride = (bw + 7) / 8;
+		uint8_t col = 0;
+		uint8_t row = 0;
+		int16_t runStart = -1;
+
+		// PackBits state
+		uint8_t count = 0;
+		bool repeat = false;
+		int value = 0;
+
+		while (row < bh) {
+			if (encoding == GLCD_BITMAP_PACKBITS) {
+				if (count == 0) {
+					int header = readBitmapByte();
+					if (header < 0)
+						break;
+					int8_t n = (int8_t)header;
+					if (n == -128)
+						continue;
+					if (n >= 0) {
+						count = n + 1;
+						repeat = false;
+					}
+					else {
+						count = 1 - n;
+						repeat = true;
+						value = readBitmapByte();
+					}
+				}
+				if (!repeat)
+					value = readBitmapByte();
+				count--;
+			}
+			else {
+				value = readBitmapByte();
+			}
+
+			if (value < 0)
+				break;
+
+			for (uint8_t bit = 0; bit < 8; bit++) {
+				int16_t px = col * 8 + bit;
+				if (px >= bw)
+					break;
+				if (value & (0x80 >> bit)) {
+					if (runStart < 0)
+						runStart = px;
+				}
+				else if (runStart >= 0) {
+					screen->drawFastHLine(x + runStart, y + row, px - runStart, bitmapColor);
+					runStart = -1;
+				}
+			}
+
+			if (++col == stride) {
+				if (runStart >= 0) {
+					screen->drawFastHLine(x + runStart, y + row, bw - runStart, bitmapColor);
+					runStart = -1;
+				}
+				col = 0;
+				row++;
+			}
+		}
+
+		// Drop what is left of a malformed or oversized stream
+		while (readBitmapByte() >= 0);
+	}
+
+#if GLCD_BITMAP_CACHESIZE > 0
+	void clearBitmaps() {
+		bitmapCacheUsed = 0;
+		for (int i = 0; i < GLCD_BITMAP_MAXSLOTS; i++) {
+			bitmapSlots[i].length = 0;
+		}
+	}
+
+	void removeBitmap(uint8_t slot) {
+		SHGLCDBitmapSlot& removed = bitmapSlots[slot];
+		if (removed.length == 0)
+			return;
+
+		uint16_t end = removed.offset + removed.length;
+		memmove(bitmapCache + removed.offset, bitmapCache + end, bitmapCacheUsed - end);
+		bitmapCacheUsed -= removed.length;
+
+		for (int i = 0; i < GLCD_BITMAP_MAXSLOTS; i++) {
+			if (bitmapSlots[i].length > 0 && bitmapSlots[i].offset >= end) {
+				bitmapSlots[i].offset -= removed.length;
+			}
+		}
+		removed.length = 0;
+	}
+
+	// Returns true when the bitmap has been stored
+	bool storeBitmap(uint8_t slot, uint8_t bw, uint8_t bh, uint8_t encoding, uint16_t length) {
+		if (slot < GLCD_BITMAP_MAXSLOTS) {
+			removeBitmap(slot);
+		}
+
+		if (slot >= GLCD_BITMAP_MAXSLOTS || length == 0 || length > GLCD_BITMAP_CACHESIZE - bitmapCacheUsed) {
+			for (uint16_t i = 0; i < length; i++) {
+				FlowSerialTimedRead();
+			}
+			return false;
+		}
+
+		SHGLCDBitmapSlot& stored = bitmapSlots[slot];
+		stored.offset = bitmapCacheUsed;
+		stored.w = bw;
+		stored.h = bh;
+		stored.encoding = encoding;
+
+		for (uint16_t i = 0; i < length; i++) {
+			bitmapCache[bitmapCacheUsed++] = FlowSerialTimedRead();
+		}
+		stored.length = length;
+		return true;
+	}
+#else
+	void clearBitmaps() {
+	}
+
+	bool storeBitmap(uint8_t slot, uint8_t bw, uint8_t bh, uint8_t encoding, uint16_t length) {
+		for (uint16_t i = 0; i < length; i++) {
+			FlowSerialTimedRead();
+		}
+		return false;
+	}
+#endif
+
+	// 'D' x, y, w, h, color, encoding, length, data : draws a streamed bitmap
+	// 'S' slot, w, h, encoding, length, data : stores a bitmap, replies 1 when stored, 0 otherwise
+	// 'U' slot, x, y, color : draws a stored bitmap
+	// 'X' : clears all stored bitmaps
+	// '?' : replies the slot count and the cache size (16 bits)
+	// x, y and length are 16 bits little endian, encoding is GLCD_BITMAP_RAW or GLCD_BITMAP_PACKBITS
+	void readBitmap() {
+		char bitmapAction = FlowSerialTimedRead();
+
+		if (bitmapAction == 'D') {
+			posX = readInt16();
+			posY = readInt16();
+			uint8_t bw = FlowSerialTimedRead();
+			uint8_t bh = FlowSerialTimedRead();
+			color = FlowSerialTimedRead();
+			uint8_t encoding = FlowSerialTimedRead();
+
+			bitmapSource = 0;
+			bitmapRemaining = readInt16();
+			drawBitmap(currentNokia, posX, posY, bw, bh, encoding, color);
+		}
+		else if (bitmapAction == 'S') {
+			uint8_t slot = FlowSerialTimedRead();
+			uint8_t bw = FlowSerialTimedRead();
+			uint8_t bh = FlowSerialTimedRead();
+			uint8_t encoding = FlowSerialTimedRead();
+			uint16_t length = readInt16();
+
+			FlowSerialWrite((byte)(storeBitmap(slot, bw, bh, encoding, length) ? 1 : 0));
+			FlowSerialFlush();
+		}
+		else if (bitmapAction == 'U') {
+			uint8_t slot = FlowSerialTimedRead();
+			posX = readInt16();
+			posY = readInt16();
+			color = FlowSerialTimedRead();
+
+#if GLCD_BITMAP_CACHESIZE > 0
+			if (slot < GLCD_BITMAP_MAXSLOTS && bitmapSlots[slot].length > 0) {
+				SHGLCDBitmapSlot& stored = bitmapSlots[slot];
+				bitmapSource = bitmapCache + stored.offset;
+				bitmapRemaining = stored.length;
+				drawBitmap(currentNokia, posX, posY, stored.w, stored.h, stored.encoding, color);
+			}
+#endif
+		}
+		else if (bitmapAction == 'X') {
+			clearBitmaps();
+		}
+		else if (bitmapAction == '?') {
+			FlowSerialWrite((byte)GLCD_BITMAP_MAXSLOTS);
+			FlowSerialWrite((byte)(GLCD_BITMAP_CACHESIZE & 0xFF));
+			FlowSerialWrite((byte)(GLCD_BITMAP_CACHESIZE >> 8));
+			FlowSerialFlush();
+		}
+	}
+
+	// 'G' needle : cx, cy, angle, inner radius, outer radius, thickness, color
+	// 'A' arc : cx, cy, radius, start angle, end angle, thickness, color
+	// 16 bits little endian values, angles in degrees clockwise from 12 o'clock
+	void readArcParams(char kind) {
+		posX = readInt16();
+		posY = readInt16();
+		int16_t a = readInt16();
+		int16_t b = readInt16();
+		int16_t c = readInt16();
+		int thickness = FlowSerialTimedRead();
+		color = FlowSerialTimedRead();
+
+		if (kind == 'G')
+			drawNeedle(currentNokia, posX, posY, a, b, c, thickness, color);
+		else
+			drawArc(currentNokia, posX, posY, a, thickness, b, c, color);
+	}
+
+	// '?' : capacity, 'X' : clear layout, 'A' : add item, 'R' : redraw screen layout,
+	// 'V' : count then (slot, value '\n') pairs, redraws the texts bound to changed slots
+	void readLayout() {
+		char layoutAction = FlowSerialTimedRead();
+
+		if (layoutAction == '?') {
+			FlowSerialWrite((byte)GLCD_LAYOUT_MAXITEMS);
+			FlowSerialWrite((byte)GLCD_LAYOUT_MAXSLOTS);
+			FlowSerialFlush();
+		}
+		else if (layoutAction == 'X') {
+			clearLayout();
+		}
+		else if (layoutAction == 'A') {
+			addLayoutItem();
+		}
+		else if (layoutAction == 'R') {
+			redrawLayout();
+		}
+		else if (layoutAction == 'V') {
+			readLayoutSlots();
+		}
+	}
+
 public:
 
+	SHGLCD_Base() {
+		clearLayout();
+		clearBitmaps();
+	}
+
 	virtual void Init() = 0;
 
 	virtual void Display(int idx) = 0;
@@ -85,45 +908,17 @@ public:
 
 		else if (action == 'P')
 		{
-			currentNokia->setTextSize((uint8_t)FlowSerialTimedRead());
+			uint8_t textSize = (uint8_t)FlowSerialTimedRead();
 			fontType = (uint8_t)FlowSerialTimedRead();
 			posX = (int16_t)FlowSerialTimedRead();
 			posY = (int16_t)FlowSerialTimedRead();
-			currentNokia->setTextColor(FlowSerialTimedRead());
-			currentNokia->setTextWrap(FlowSerialTimedRead() > 0);
+			color = FlowSerialTimedRead();
+			bool wrap = FlowSerialTimedRead() > 0;
 			align = FlowSerialTimedRead();
 
 			String content = FlowSerialReadStringUntil('\n');
 
-			currentNokia->setFont();
-
-			if (fontType == 1) {
-				currentNokia->setFont(&CUSTOM_LCD_FONT_1);
-			}
-			else if (fontType == 2) {
-				currentNokia->setFont(&CUSTOM_LCD_FONT_2);
-			}
-
-#ifdef CUSTOM_LCD_FONT_3
-			else if (fontType == 3) {
-				currentNokia->setFont(&CUSTOM_LCD_FONT_3);
-			}
-#endif
-
-			if (align == 2)
-			{
-				String content2 = content + "\n ";
-				currentNokia->getTextBounds((char*)content2.c_str(), 0, 0, &boundX, &boundY, &boundW, &boundH);
-				posX = posX - (boundW / 2);
-			}
-			else if (align == 3)
-			{
-				String content2 = content + "\n ";
-				currentNokia->getTextBounds((char*)content2.c_str(), 0, 0, &boundX, &boundY, &boundW, &boundH);
-				posX = posX - boundW;
-			}
-
-			currentNokia->setCursor(posX, posY);
+			prepareText(currentNokia, textSize, fontType, posX, posY, color, wrap, align, content.c_str());
 			currentNokia->print(content);
 		}
 		else if (action == 'L') {
@@ -143,29 +938,7 @@ public:
 			int thickness = FlowSerialTimedRead();
 			color = FlowSerialTimedRead();
 
-			float dx = posX - w;
-			float dy = posY - h;
-			float d = sqrtf(dx * dx + dy * dy);
-			if (!d)
-				return;
-
-			int v[4 * 2];
-
-			/* left up */
-			v[0] = posX - thickness * dy / d;
-			v[1] = posY + thickness * dx / d;
-			/* right up */
-			v[2] = posX + thickness * dy / d;
-			v[3] = posY - thickness * dx / d;
-			/* right down */
-			v[4] = w + thickness * dy / d;
-			v[5] = h - thickness * dx / d;
-			/* left down */
-			v[6] = w - thickness * dy / d;
-			v[7] = h + thickness * dx / d;
-
-			currentNokia->fillTriangle(v[0], v[1], v[6], v[7], v[2], v[3], color);
-			currentNokia->fillTriangle(v[2], v[3], v[4], v[5], v[6], v[7], color);
+			drawThickLine(currentNokia, posX, posY, w, h, thickness, color);
 		}
 
 		else if (action == 'F' || action == 'R')
@@ -177,19 +950,32 @@ public:
 			r = (int16_t)FlowSerialTimedRead();
 			color = FlowSerialTimedRead();
 
-			if (r == 0) {
-				if (action == 'F')
-					currentNokia->fillRect(posX, posY, w, h, color);
-				else
-					currentNokia->drawRect(posX, posY, w, h, color);
-			}
-			else {
-				if (action == 'F')
-					currentNokia->fillRoundRect(posX, posY, w, h, r, color);
-				else
-					currentNokia->drawRoundRect(posX, posY, w, h, r, color);
-			}
+			drawRect(currentNokia, action == 'F', posX, posY, w, h, r, color);
+		}
+
+		else if (action == 'G' || action == 'A')
+		{
+			readArcParams(action);
+		}
+
+		// 1 bpp bitmaps, streamed or stored in the bitmap cache
+		else if (action == 'M')
+		{
+			readBitmap();
+		}
+
+		// Many primitives in a single frame, see readBatch
+		else if (action == 'B')
+		{
+			readBatch();
+		}
+
+		// Retained layout : static primitives and value slots are uploaded once,
+		// then only slot values are sent and the bound texts are redrawn
+		else if (action == 'Y')
+		{
+			readLayout();
 		}
 	}
 };
-#endif
\ No newline at end of file
+#endif
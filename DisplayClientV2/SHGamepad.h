@@ -0,0 +1,104 @@
+#ifndef __SHGAMEPAD_H__
+#define __SHGAMEPAD_H__
+
+#include <Arduino.h>
+#include <Joystick.h>
+
+// Minimum time between two reports, can be overridden before including this file
+#ifndef GAMEPAD_REPORT_INTERVAL_US
+#define GAMEPAD_REPORT_INTERVAL_US 1000
+#endif
+
+#define GAMEPAD_MAXBUTTONS 128
+
+// X, Y, Z, Rx, Ry, Rz
+#define GAMEPAD_MAXAXES 6
+
+// Keeps the button and axis states given to the Joystick library, a report is only sent when
+// something changed, changes made within GAMEPAD_REPORT_INTERVAL_US go in the same report.
+// Changes undone before the report (a short button press) send nothing.
+class SHGamepad {
+private:
+	Joystick_ * joystick;
+	uint8_t buttons[GAMEPAD_MAXBUTTONS / 8];
+	int32_t axes[GAMEPAD_MAXAXES];
+	// States of the last report
+	uint8_t sentButtons[GAMEPAD_MAXBUTTONS / 8];
+	int32_t sentAxes[GAMEPAD_MAXAXES];
+	bool dirty = false;
+	unsigned long lastReport;
+
+public:
+	void begin(Joystick_ * joystickInstance) {
+		joystick = joystickInstance;
+		memset(buttons, 0, sizeof(buttons));
+		memset(axes, 0, sizeof(axes));
+		memset(sentButtons, 0, sizeof(sentButtons));
+		memset(sentAxes, 0, sizeof(sentAxes));
+		joystick->begin(false);
+		lastReport = micros();
+	}
+
+	void setButton(uint8_t button, bool pressed) {
+		if (button >= GAMEPAD_MAXBUTTONS)
+			return;
+
+		uint8_t mask = 1 << (button & 7);
+		uint8_t & state = buttons[button >> 3];
+		if (((state & mask) != 0) == pressed)
+			return;
+
+		state ^= mask;
+		joystick->setButton(button, pressed);
+		dirty = true;
+	}
+
+	// The axis must be enabled in the Joystick_ constructor
+	void setAxisRange(uint8_t axis, int32_t minimum, int32_t maximum) {
+		switch (axis) {
+		case 0: joystick->setXAxisRange(minimum, maximum); break;
+		case 1: joystick->setYAxisRange(minimum, maximum); break;
+		case 2: joystick->setZAxisRange(minimum, maximum); break;
+		case 3: joystick->setRxAxisRange(minimum, maximum); break;
+		case 4: joystick->setRyAxisRange(minimum, maximum); break;
+		case 5: joystick->setRzAxisRange(minimum, maximum); break;
+		}
+	}
+
+	void setAxis(uint8_t axis, int32_t value) {
+		if (axis >= GAMEPAD_MAXAXES || axes[axis] == value)
+			return;
+
+		axes[axis] = value;
+		switch (axis) {
+		case 0: joystick->setXAxis(value); break;
+		case 1: joystick->setYAxis(value); break;
+		case 2: joystick->setZAxis(value); break;
+		case 3: joystick->setRxAxis(value); break;
+		case 4: joystick->setRyAxis(value); break;
+		case 5: joystick->setRzAxis(value); break;
+		}
+		dirty = true;
+	}
+
+	// Sends the pending changes once the report interval elapsed, to be called from loop() and idle()
+	void update() {
+		if (!dirty)
+			return;
+
+		unsigned long now = micros();
+		if (now - lastReport < GAMEPAD_REPORT_INTERVAL_US)
+			return;
+
+		dirty = false;
+		if (memcmp(buttons, sentButtons, sizeof(buttons)) == 0 && memcmp(axes, sentAxes, sizeof(axes)) == 0)
+			return;
+
+		joystick->sendState();
+		memcpy(sentButtons, buttons, sizeof(buttons));
+		memcpy(sentAxes, axes, sizeof(axes));
+		lastReport = now;
+	}
+};
+
+#endif
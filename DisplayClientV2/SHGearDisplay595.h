@@ -0,0 +1,104 @@
+#ifndef __SHGEARDISPLAY595_H__
+#define __SHGEARDISPLAY595_H__
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "SHFastIO.h"
+
+// Longest supported chain, can be overridden before including this file
+#ifndef GEAR595_MAXDIGITS
+#define GEAR595_MAXDIGITS 4
+#endif
+
+// Font entries after the 10 digits
+#define GEAR595_FONT_BLANK 10
+#define GEAR595_FONT_REVERSE 11
+#define GEAR595_FONT_NEUTRAL 12
+
+// 7 segments digits on chained 595 shift registers (74HC595, TPIC6C595), one register per digit.
+// Digit 0 is the register wired to the MCU. The chain is only shifted out when a character changed,
+// with hardware SPI when the data and clock pins are MOSI and SCK.
+template <uint8_t DATAPIN, uint8_t CLOCKPIN, uint8_t LATCHPIN>
+class SHGearDisplay595 {
+private:
+	static bool hardwareSPI() { return DATAPIN == MOSI && CLOCKPIN == SCK; }
+
+	// 13 entries : '0' to '9', ' ', 'R', 'N'
+	const byte * font;
+	byte invert;
+
+	byte digitCount;
+	char chars[GEAR595_MAXDIGITS];
+	bool dirty;
+
+	byte encode(char c) {
+		byte data = 0;
+		if (c == ' ') {
+			data = font[GEAR595_FONT_BLANK];
+		}
+		else if (c == 'R') {
+			data = font[GEAR595_FONT_REVERSE];
+		}
+		else if (c == 'N') {
+			data = font[GEAR595_FONT_NEUTRAL];
+		}
+		else if (c >= '0' && c <= '9') {
+			data = font[c - '0'];
+		}
+		return invert ? data ^ 0xFF : data;
+	}
+
+	void send() {
+		FastPin<LATCHPIN>::low();
+		// The first byte ends in the last register of the chain
+		if (hardwareSPI()) {
+			SPI.beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
+			for (int i = digitCount - 1; i >= 0; i--) {
+				SPI.transfer(encode(chars[i]));
+			}
+			SPI.endTransaction();
+		}
+		else {
+			for (int i = digitCount - 1; i >= 0; i--) {
+				fastShiftOut<DATAPIN, CLOCKPIN>(MSBFIRST, encode(chars[i]));
+			}
+		}
+		// Outputs change on the rising edge
+		FastPin<LATCHPIN>::high();
+	}
+
+public:
+	void begin(byte digitCount, const byte * font, byte invert, char initialChar) {
+		this->digitCount = digitCount < GEAR595_MAXDIGITS ? digitCount : GEAR595_MAXDIGITS;
+		this->font = font;
+		this->invert = invert;
+
+		FastPin<DATAPIN>::mode(OUTPUT);
+		FastPin<CLOCKPIN>::mode(OUTPUT);
+		FastPin<LATCHPIN>::mode(OUTPUT);
+
+		if (hardwareSPI())
+			SPI.begin();
+
+		memset(chars, initialChar, sizeof(chars));
+		send();
+		dirty = false;
+	}
+
+	void setChar(byte digit, char c) {
+		if (digit < digitCount && chars[digit] != c) {
+			chars[digit] = c;
+			dirty = true;
+		}
+	}
+
+	// Sends the chain when a character changed
+	void update() {
+		if (dirty) {
+			send();
+			dirty = false;
+		}
+	}
+};
+
+#endif
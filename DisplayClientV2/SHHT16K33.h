@@ -0,0 +1,53 @@
+#ifndef __SHHT16K33_H__
+#define __SHHT16K33_H__
+
+#include <Arduino.h>
+#include "SHI2CQueue.h"
+
+// Queues a write of the whole display RAM, same layout as Adafruit_LEDBackpack::displaybuffer
+void HT16K33_QueueDisplay(uint8_t address, const uint16_t * displaybuffer) {
+	i2cQueue.beginWrite(I2CQUEUE_PRIORITY_NORMAL, address, 17, true);
+	// Display RAM address 0
+	i2cQueue.write((uint8_t)0x00);
+	for (uint8_t i = 0; i < 8; i++) {
+		i2cQueue.write((uint8_t)(displaybuffer[i] & 0xFF));
+		i2cQueue.write((uint8_t)(displaybuffer[i] >> 8));
+	}
+}
+
+// Queues the dimming command, brightness 0-15
+void HT16K33_QueueBrightness(uint8_t address, uint8_t brightness) {
+	i2cQueue.beginWrite(I2CQUEUE_PRIORITY_NORMAL, address, 1, true);
+	i2cQueue.write((uint8_t)(0xE0 | (brightness > 15 ? 15 : brightness)));
+}
+
+// Column c of an 8x8 frame given as rows (MSB on the left), bit j is the pixel of row j
+byte HT16K33_FrameColumn(const byte * rows, uint8_t c) {
+	byte mask = 0x80 >> c;
+	byte column = 0;
+	byte bit = 1;
+	for (uint8_t j = 0; j < 8; j++) {
+		if (rows[j] & mask)
+			column |= bit;
+		bit <<= 1;
+	}
+	return column;
+}
+
+// Fills the display RAM with the same layout as drawPixel(row, column) on an
+// Adafruit_8x8matrix (column byte rotated right by 1) or an Adafruit_BicolorMatrix
+// (column byte in the red half), returns false when the contents didn't change
+bool HT16K33_SetFrame(uint16_t * displaybuffer, const byte * rows, bool bicolor) {
+	bool changed = false;
+	for (uint8_t c = 0; c < 8; c++) {
+		byte column = HT16K33_FrameColumn(rows, c);
+		uint16_t value = bicolor ? (uint16_t)column << 8 : (byte)((column >> 1) | (column << 7));
+		if (displaybuffer[c] != value) {
+			displaybuffer[c] = value;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef __SHHAPTICS_H__
+#define __SHHAPTICS_H__
+
+#include <Arduino.h>
+#include "SHShakeitBase.h"
+
+// Effects played at the same time, can be overridden before including this file
+#ifndef HAPTICS_MAXEFFECTS
+#define HAPTICS_MAXEFFECTS 4
+#endif
+
+// Synthesis rate
+#ifndef HAPTICS_RATE_HZ
+#define HAPTICS_RATE_HZ 500
+#endif
+
+#define HAPTICS_MAXPROVIDERS 5
+#define HAPTICS_ALLMOTORS 0xFF
+
+#define HAPTICS_WAVE_SINE 0
+#define HAPTICS_WAVE_SQUARE 1
+#define HAPTICS_WAVE_TRIANGLE 2
+#define HAPTICS_WAVE_SAWTOOTH 3
+#define HAPTICS_WAVE_NOISE 4     // new random level each period, road texture
+#define HAPTICS_WAVE_CONSTANT 5  // envelope only, gear shift kick
+
+// Half sine, 0-255
+const uint8_t HAPTICS_SINE[17] PROGMEM = { 0, 25, 50, 74, 98, 120, 142, 162, 180, 197, 212, 225, 236, 244, 250, 254, 255 };
+
+struct SHHapticEffect {
+	bool active;
+	uint8_t motor;
+	uint8_t waveform;
+	uint16_t frequency;  // Hz
+	uint8_t amplitude;
+	uint16_t attack;     // ms
+	uint16_t decay;      // ms
+	uint8_t sustain;     // level after the decay, 0-255 of the amplitude
+	uint16_t release;    // ms
+	uint16_t duration;   // ms before the release, 0 until stopped
+
+	unsigned long start;
+	unsigned long releaseStart;
+	uint8_t releaseLevel;
+	bool releasing;
+	uint16_t phase;
+	uint8_t noise;
+};
+
+// Effects synthesized on the device and mixed onto the SHShakeit motors, so the host only sends
+// effect descriptors instead of the high frequency content.
+// Motors are numbered as in the motors frame, across the providers in the order they were added.
+// Effects stop when the host is silent for SHShakeitBaseSafetyDelay.
+class SHHaptics {
+private:
+	SHShakeitBase * providers[HAPTICS_MAXPROVIDERS];
+	uint8_t providersCount = 0;
+
+	SHHapticEffect effects[HAPTICS_MAXEFFECTS];
+	unsigned long lastUpdate;
+	unsigned long lastKeepAlive;
+	uint8_t lfsr = 0xE1;
+
+	uint8_t randomLevel() {
+		// 8 bits galois LFSR
+		lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB8);
+		return lfsr;
+	}
+
+	uint8_t wave(SHHapticEffect & e) {
+		uint16_t previous = e.phase;
+		e.phase += (uint32_t)e.frequency * 65536 / HAPTICS_RATE_HZ;
+
+		switch (e.waveform) {
+		case HAPTICS_WAVE_SINE: {
+			// Offset sine, from 0 to 255
+			uint8_t index = (e.phase >> 10) & 0x1F;
+			uint8_t quarter = index < 16 ? index : 32 - index;
+			uint8_t half = pgm_read_byte(HAPTICS_SINE + quarter) >> 1;
+			return e.phase < 32768 ? 128 + half : 128 - half;
+		}
+		case HAPTICS_WAVE_SQUARE:
+			return e.phase < 32768 ? 255 : 0;
+		case HAPTICS_WAVE_TRIANGLE:
+			return e.phase < 32768 ? e.phase >> 7 : 255 - ((e.phase - 32768) >> 7);
+		case HAPTICS_WAVE_SAWTOOTH:
+			return e.phase >> 8;
+		case HAPTICS_WAVE_NOISE:
+			if (e.phase < previous)
+				e.noise = randomLevel();
+			return e.noise;
+		default:
+			return 255;
+		}
+	}
+
+	// Attack, decay and sustain level 0-255
+	static uint8_t holdLevel(SHHapticEffect & e, unsigned long now) {
+		unsigned long t = now - e.start;
+		if (t < e.attack)
+			return t * 255 / e.attack;
+		t -= e.attack;
+		if (t < e.decay)
+			return 255 - (uint32_t)(255 - e.sustain) * t / e.decay;
+		return e.sustain;
+	}
+
+	// ADSR level 0-255, deactivates the effect once released
+	uint8_t envelope(SHHapticEffect & e, unsigned long now) {
+		if (e.duration > 0 && now - e.start >= e.duration) {
+			stop(e, now);
+		}
+
+		if (!e.releasing)
+			return holdLevel(e, now);
+
+		unsigned long t = now - e.releaseStart;
+		if (t >= e.release) {
+			e.active = false;
+			return 0;
+		}
+		return e.releaseLevel - (uint32_t)e.releaseLevel * t / e.release;
+	}
+
+	static void stop(SHHapticEffect & e, unsigned long now) {
+		if (!e.active || e.releasing)
+			return;
+		e.releaseLevel = holdLevel(e, now);
+		e.releasing = true;
+		e.releaseStart = now;
+	}
+
+public:
+
+	// Providers must be added in the motors frame order
+	void addProvider(SHShakeitBase * provider) {
+		if (providersCount < HAPTICS_MAXPROVIDERS)
+			providers[providersCount++] = provider;
+	}
+
+	// Reads an effect descriptor : slot, motor (HAPTICS_ALLMOTORS for all), waveform,
+	// frequency (uint16 Hz), amplitude, attack, decay (uint16 ms), sustain level, release, duration (uint16 ms)
+	void readEffect() {
+		uint8_t slot = FlowSerialTimedRead();
+		SHHapticEffect e;
+		e.motor = FlowSerialTimedRead();
+		e.waveform = FlowSerialTimedRead();
+		e.frequency = FlowSerialTimedRead();
+		e.frequency |= FlowSerialTimedRead() << 8;
+		e.amplitude = FlowSerialTimedRead();
+		e.attack = FlowSerialTimedRead();
+		e.attack |= FlowSerialTimedRead() << 8;
+		e.decay = FlowSerialTimedRead();
+		e.decay |= FlowSerialTimedRead() << 8;
+		e.sustain = FlowSerialTimedRead();
+		e.release = FlowSerialTimedRead();
+		e.release |= FlowSerialTimedRead() << 8;
+		e.duration = FlowSerialTimedRead();
+		e.duration |= FlowSerialTimedRead() << 8;
+
+		if (slot >= HAPTICS_MAXEFFECTS)
+			return;
+
+		e.active = true;
+		e.releasing = false;
+		e.start = millis();
+		e.phase = 0;
+		e.noise = 0;
+		effects[slot] = e;
+		keepAlive();
+	}
+
+	// Releases an effect slot, 0xFF for all
+	void readStop() {
+		uint8_t slot = FlowSerialTimedRead();
+		unsigned long now = millis();
+		for (uint8_t i = 0; i < HAPTICS_MAXEFFECTS; i++) {
+			if (slot == HAPTICS_ALLMOTORS || slot == i)
+				stop(effects[i], now);
+		}
+		keepAlive();
+	}
+
+	// Effects and motor frames keep the effects running
+	void keepAlive() {
+		lastKeepAlive = millis();
+	}
+
+	// Synthesizes the effects every 1 / HAPTICS_RATE_HZ, to be called from loop() and idle()
+	void update() {
+		unsigned long nowUs = micros();
+		if (nowUs - lastUpdate < 1000000UL / HAPTICS_RATE_HZ)
+			return;
+		lastUpdate = nowUs;
+
+		unsigned long now = millis();
+		bool expired = now - lastKeepAlive > SHShakeitBaseSafetyDelay;
+
+		uint8_t levels[HAPTICS_MAXEFFECTS];
+		for (uint8_t i = 0; i < HAPTICS_MAXEFFECTS; i++) {
+			SHHapticEffect & e = effects[i];
+			if (expired)
+				e.active = false;
+			levels[i] = e.active ? (uint16_t)wave(e) * envelope(e, now) / 255 * e.amplitude / 255 : 0;
+		}
+
+		uint8_t motor = 0;
+		for (uint8_t p = 0; p < providersCount; p++) {
+			uint8_t count = providers[p]->motorCount();
+			for (uint8_t m = 0; m < count; m++, motor++) {
+				uint16_t level = 0;
+				for (uint8_t i = 0; i < HAPTICS_MAXEFFECTS; i++) {
+					if (effects[i].motor == motor || effects[i].motor == HAPTICS_ALLMOTORS)
+						level += levels[i];
+				}
+				providers[p]->setEffectLevel(m, level > 255 ? 255 : level);
+			}
+		}
+	}
+};
+
+SHHaptics haptics;
+
+#endif
@@ -2,35 +2,248 @@
 #define __SHI2CLCDBASE_H__
 
 #include <Arduino.h>
+#include "SHI2CQueue.h"
 
+// Largest supported LCD (2004)
+#define I2CLCD_MAXWIDTH 20
+#define I2CLCD_MAXHEIGHT 4
+
+// PCF8574 to HD44780 wiring, the same for both supported libraries
+#define I2CLCD_RS 0x01
+#define I2CLCD_EN 0x04
+#define I2CLCD_BACKLIGHT 0x08
+
+// Bar widgets, can be overridden before including this file
+#ifndef I2CLCD_MAXBARS
+#define I2CLCD_MAXBARS 4
+#endif
+
+// Bars use CGRAM slots 0 to 3 for the partially filled cells,
+// slots 4 to 7 are left for host defined glyphs
+#define I2CLCD_BAR_GLYPHS 4
+#define I2CLCD_FULL_BLOCK 0xFF
+
+struct SHI2CLcdBar {
+	uint8_t row;
+	uint8_t col;
+	uint8_t length;
+};
 
 class SHI2CLcdBase {
 private:
 	int _width;
 	int _height;
+	uint8_t _address;
+
+	// Characters currently shown on the LCD, rows not set in shadowValidRows are unknown
+	char shadow[I2CLCD_MAXHEIGHT][I2CLCD_MAXWIDTH];
+	uint8_t shadowValidRows;
+
+	// CGRAM contents, slots not set in cgramValid are unknown
+	uint8_t cgram[8][8];
+	uint8_t cgramValid;
+
+	SHI2CLcdBar bars[I2CLCD_MAXBARS];
+	uint8_t barsCount;
+
+	// Uploads a glyph only when it differs from the CGRAM contents
+	void loadGlyph(uint8_t slot, uint8_t * rows) {
+		if ((cgramValid & (1 << slot)) && memcmp(cgram[slot], rows, 8) == 0)
+			return;
+
+		memcpy(cgram[slot], rows, 8);
+		cgramValid |= (1 << slot);
+
+		// Library call, keeps the LCD command order
+		i2cQueue.flush();
+		createChar(slot, cgram[slot]);
+	}
+
+	// Glyph n has the n + 1 left columns filled
+	void loadBarGlyphs() {
+		uint8_t rows[8];
+		for (uint8_t n = 0; n < I2CLCD_BAR_GLYPHS; n++) {
+			memset(rows, (0x1F << (4 - n)) & 0x1F, 8);
+			loadGlyph(n, rows);
+		}
+	}
+
+	// Value 0-255 spread over length cells of 5 columns
+	void drawBar(SHI2CLcdBar & bar, uint8_t value) {
+		char text[I2CLCD_MAXWIDTH];
+		uint16_t filled = ((uint16_t)value * bar.length * 5 + 127) / 255;
+
+		for (uint8_t i = 0; i < bar.length; i++) {
+			int16_t columns = (int16_t)filled - i * 5;
+			if (columns <= 0)
+				text[i] = ' ';
+			else if (columns >= 5)
+				text[i] = (char)I2CLCD_FULL_BLOCK;
+			else
+				text[i] = (char)(columns - 1);
+		}
+		writeChanged(bar.col, bar.row, text, bar.length);
+	}
+
+protected:
+
+	// 4 bits mode : each nibble is latched by an enable pulse
+	void queueLcdByte(uint8_t value, bool data) {
+		uint8_t flags = I2CLCD_BACKLIGHT | (data ? I2CLCD_RS : 0);
+		uint8_t high = (value & 0xF0) | flags;
+		uint8_t low = (value << 4) | flags;
+
+		i2cQueue.write((uint8_t)(high | I2CLCD_EN));
+		i2cQueue.write(high);
+		i2cQueue.write((uint8_t)(low | I2CLCD_EN));
+		i2cQueue.write(low);
+	}
+
+	// Moves the cursor then writes the characters, as queued transactions of up to 8 LCD bytes.
+	// Commands take less than 40us, shorter than the following I2C bytes, so no delay is needed.
+	void queueRun(uint8_t col, uint8_t row, const char * text, uint8_t length) {
+		static const uint8_t rowOffsets[I2CLCD_MAXHEIGHT] = { 0x00, 0x40, 0x14, 0x54 };
+		bool first = true;
+
+		while (length > 0) {
+			uint8_t count = first ? 7 : 8;
+			if (count > length)
+				count = length;
+
+			i2cQueue.beginWrite(I2CQUEUE_PRIORITY_NORMAL, _address, (count + (first ? 1 : 0)) * 4, false);
+			if (first) {
+				// Set DDRAM address
+				queueLcdByte(0x80 | (col + rowOffsets[row]), false);
+			}
+			for (uint8_t i = 0; i < count; i++) {
+				queueLcdByte(text[i], true);
+			}
+
+			text += count;
+			length -= count;
+			first = false;
+		}
+	}
+
+	// Writes the characters differing from the shadow, the LCD address counter
+	// auto increments so the cursor is only moved at the start of each changed run
+	void writeChanged(uint8_t col, uint8_t row, const char * text, uint8_t length) {
+		bool rowValid = shadowValidRows & (1 << row);
+
+		if (length > _width - col)
+			length = _width - col;
+
+		uint8_t i = 0;
+		while (i < length) {
+			if (rowValid && shadow[row][col + i] == text[i]) {
+				i++;
+				continue;
+			}
+
+			uint8_t start = i;
+			while (i < length && !(rowValid && shadow[row][col + i] == text[i])) {
+				shadow[row][col + i] = text[i];
+				i++;
+			}
+			queueRun(col + start, row, text + start, i - start);
+		}
+
+		// A row is known once written from its first column
+		if (col == 0 && length >= _width) {
+			shadowValidRows |= (1 << row);
+		}
+	}
+
 public:
 
-	void begin(int width, int height, bool test) {
-		_width = width;
-		_height = height;
+	void begin(uint8_t address, int width, int height, bool test) {
+		_address = address;
+		_width = width < I2CLCD_MAXWIDTH ? width : I2CLCD_MAXWIDTH;
+		_height = height < I2CLCD_MAXHEIGHT ? height : I2CLCD_MAXHEIGHT;
+
+		// Screen is cleared after init unless the test message is kept
+		memset(shadow, ' ', sizeof(shadow));
+		shadowValidRows = test ? 0 : 0xFF;
+		cgramValid = 0;
+		barsCount = 0;
 	}
 
 	void read() {
+		char text[I2CLCD_MAXWIDTH];
+		uint8_t length = 0;
+
 		// Skip one byte
 		FlowSerialTimedRead();
 		int row = FlowSerialTimedRead();
-		if (row < _height) {
-			setCursor(0, row);
-			print(FlowSerialReadStringUntil('\n').substring(0, _width));
+
+		int c = FlowSerialTimedRead();
+		while (c >= 0 && c != '\n') {
+			if (length < _width) {
+				text[length++] = (char)c;
+			}
+			c = FlowSerialTimedRead();
+		}
+
+		if (row >= 0 && row < _height) {
+			writeChanged(0, row, text, length);
+		}
+	}
+
+	// 'C' slot, 8 rows : defines a custom glyph, only uploaded when changed
+	// 'D' count, (row, col, length) * count : defines the bars
+	// 'V' count, value * count : bar values (0-255), in definition order
+	// '?' : replies the max bar count
+	void readWidgets() {
+		char widgetAction = FlowSerialTimedRead();
+
+		if (widgetAction == 'C') {
+			uint8_t slot = FlowSerialTimedRead();
+			uint8_t rows[8];
+			for (uint8_t i = 0; i < 8; i++) {
+				rows[i] = FlowSerialTimedRead() & 0x1F;
+			}
+			if (slot < 8) {
+				loadGlyph(slot, rows);
+			}
+		}
+		else if (widgetAction == 'D') {
+			uint8_t count = FlowSerialTimedRead();
+			barsCount = 0;
+			for (uint8_t i = 0; i < count; i++) {
+				SHI2CLcdBar bar;
+				bar.row = FlowSerialTimedRead();
+				bar.col = FlowSerialTimedRead();
+				bar.length = FlowSerialTimedRead();
+
+				if (barsCount < I2CLCD_MAXBARS && bar.row < _height && bar.col < _width) {
+					if (bar.length > _width - bar.col)
+						bar.length = _width - bar.col;
+					bars[barsCount++] = bar;
+				}
+			}
+		}
+		else if (widgetAction == 'V') {
+			uint8_t count = FlowSerialTimedRead();
+			if (barsCount > 0) {
+				loadBarGlyphs();
+			}
+			for (uint8_t i = 0; i < count; i++) {
+				uint8_t value = FlowSerialTimedRead();
+				if (i < barsCount) {
+					drawBar(bars[i], value);
+				}
+			}
 		}
-		else {
-			FlowSerialReadStringUntil('\n');
+		else if (widgetAction == '?') {
+			FlowSerialWrite((byte)I2CLCD_MAXBARS);
+			FlowSerialFlush();
 		}
 	}
 
 	virtual void setCursor(int x, int y);
 	virtual void print(String s);
+	virtual void createChar(uint8_t slot, uint8_t * rows);
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -10,8 +10,8 @@ private:
 	LiquidCrystal_I2C * I2CLCD;
 
 public:
-	void begin(LiquidCrystal_I2C * I2CLCDInstance, int width, int height, bool test) {
-		SHI2CLcdBase::begin(width, height, test);
+	void begin(LiquidCrystal_I2C * I2CLCDInstance, uint8_t address, int width, int height, bool test) {
+		SHI2CLcdBase::begin(address, width, height, test);
 		I2CLCD = I2CLCDInstance;
 		I2CLCD->init();
 		I2CLCD->backlight();
@@ -29,6 +29,10 @@ public:
 		 I2CLCD->print(s);
 	 }
 
+	 void createChar(uint8_t slot, uint8_t * rows) {
+		 I2CLCD->createChar(slot, rows);
+	 }
+
 
 };
 
@@ -12,8 +12,8 @@ private:
 	LiquidCrystal_PCF8574 * I2CLCD;
 
 public:
-	void begin(LiquidCrystal_PCF8574 * I2CLCDInstance, int width, int height, bool test) {
-		SHI2CLcdBase::begin(width, height, test);
+	void begin(LiquidCrystal_PCF8574 * I2CLCDInstance, uint8_t address, int width, int height, bool test) {
+		SHI2CLcdBase::begin(address, width, height, test);
 		I2CLCD = I2CLCDInstance;
 		I2CLCD->begin(width, height); // initialize the lcd
 		I2CLCD->setBacklight(255);
@@ -31,6 +31,10 @@ public:
 	void print(String s) {
 		I2CLCD->print(s);
 	}
+
+	void createChar(uint8_t slot, uint8_t * rows) {
+		I2CLCD->createChar(slot, rows);
+	}
 };
 
 #endif
\ No newline at end of file
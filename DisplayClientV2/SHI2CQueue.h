@@ -0,0 +1,121 @@
+#ifndef __SHI2CQUEUE_H__
+#define __SHI2CQUEUE_H__
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "RingBuffer.h"
+
+// Queue sizes in bytes, each transaction takes its length + 2 bytes
+#ifndef I2CQUEUE_HIGHSIZE
+#define I2CQUEUE_HIGHSIZE 64
+#endif
+
+#ifndef I2CQUEUE_NORMALSIZE
+#define I2CQUEUE_NORMALSIZE 96
+#endif
+
+#if I2CQUEUE_HIGHSIZE < 34 || I2CQUEUE_NORMALSIZE < 34 || I2CQUEUE_HIGHSIZE > 255 || I2CQUEUE_NORMALSIZE > 255
+#error "I2C queue sizes must be between 34 and 255"
+#endif
+
+#define I2CQUEUE_PRIORITY_HIGH 0
+#define I2CQUEUE_PRIORITY_NORMAL 1
+
+#define I2CQUEUE_FAST 0x80
+
+// I2C write transactions queued by the drivers and sent from idle()/loop(),
+// so read handlers return without waiting for the bus.
+// Wire owns the TWI interrupt, the queue sends one whole transaction per pump() call,
+// high priority transactions (motors) are always sent before normal ones (displays).
+class SHI2CQueue {
+private:
+	RingBuffer<uint8_t, I2CQUEUE_HIGHSIZE> highQueue;
+	RingBuffer<uint8_t, I2CQUEUE_NORMALSIZE> normalQueue;
+
+	// Transaction being written, it can't be sent before being complete
+	uint8_t writePriority;
+	uint8_t writeRemaining = 0;
+
+	template <typename TQueue>
+	bool sendFrom(TQueue & queue, bool incomplete) {
+		if (queue.isEmpty() || incomplete)
+			return false;
+
+		uint8_t header, length, value;
+		queue.pop(header);
+		queue.pop(length);
+
+		// Libraries may have changed the clock, always set it
+		Wire.setClock((header & I2CQUEUE_FAST) ? 400000 : 100000);
+
+		Wire.beginTransmission(header & 0x7F);
+		for (uint8_t i = 0; i < length; i++) {
+			queue.pop(value);
+			Wire.write(value);
+		}
+		Wire.endTransmission();
+		return true;
+	}
+
+	void push(uint8_t value) {
+		if (writePriority == I2CQUEUE_PRIORITY_HIGH)
+			highQueue.push(value);
+		else
+			normalQueue.push(value);
+	}
+
+	uint8_t freeSpace(uint8_t priority) {
+		return priority == I2CQUEUE_PRIORITY_HIGH ? highQueue.maxSize() - highQueue.size() : normalQueue.maxSize() - normalQueue.size();
+	}
+
+public:
+
+	// True when a transaction of length bytes can be started without waiting
+	bool canWrite(uint8_t priority, uint8_t length) {
+		return writeRemaining == 0 && freeSpace(priority) >= length + 2;
+	}
+
+	// Starts a transaction of length bytes (32 max), the bytes must then be given with write().
+	// Waits for room when the queue is full : writes larger than the queue (a whole SSD1306 frame)
+	// still block until their beginning has been sent.
+	// fast : device supports 400KHz
+	void beginWrite(uint8_t priority, uint8_t address, uint8_t length, bool fast) {
+		while (freeSpace(priority) < length + 2) {
+			pump();
+		}
+
+		writePriority = priority;
+		push((uint8_t)(address | (fast ? I2CQUEUE_FAST : 0)));
+		push(length);
+		writeRemaining = length;
+	}
+
+	void write(uint8_t value) {
+		if (writeRemaining > 0) {
+			push(value);
+			writeRemaining--;
+		}
+	}
+
+	void write(const uint8_t * data, uint8_t length) {
+		for (uint8_t i = 0; i < length; i++) {
+			write(data[i]);
+		}
+	}
+
+	// Sends the oldest transaction of the highest priority, returns false when nothing was sent
+	bool pump() {
+		if (sendFrom(highQueue, writeRemaining > 0 && writePriority == I2CQUEUE_PRIORITY_HIGH))
+			return true;
+		return sendFrom(normalQueue, writeRemaining > 0 && writePriority == I2CQUEUE_PRIORITY_NORMAL);
+	}
+
+	// Sends everything, to be called before blocking library calls on a queued device
+	void flush() {
+		while (pump());
+	}
+};
+
+SHI2CQueue i2cQueue;
+
+#endif
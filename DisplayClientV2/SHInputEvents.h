@@ -0,0 +1,131 @@
+#ifndef __SHINPUTEVENTS_H__
+#define __SHINPUTEVENTS_H__
+
+#include <Arduino.h>
+
+// Events kept between two flushes, can be overridden before including this file
+#ifndef INPUTEVENTS_MAX
+#define INPUTEVENTS_MAX 16
+#endif
+
+// Time a batched event can wait for others before being sent
+#ifndef INPUTEVENTS_BATCH_US
+#define INPUTEVENTS_BATCH_US 2000
+#endif
+
+// Event types, same as the single event custom packets
+#define INPUTEVENT_ENCODER 0x01        // encoder id, direction, position
+#define INPUTEVENT_ENCODERBUTTON 0x02  // encoder id, state
+#define INPUTEVENT_BUTTON 0x03         // button id, state
+#define INPUTEVENT_TM1638BUTTON 0x04   // module, button, state
+#define INPUTEVENT_ENCODERDELTA 0x07   // encoder id, accelerated delta (int8), position
+
+// Batch custom packet
+#define INPUTEVENT_BATCH 0x05
+
+struct SHInputEvent {
+	uint8_t type;
+	uint8_t data[3];
+	unsigned long time;
+};
+
+// Input events collected with their micros() time and sent from idle()/loop().
+// By default each event is sent as its own packet on the next tick, once enabled by the host (X inputevents)
+// the events collected during INPUTEVENTS_BATCH_US after the first one are sent as a single batch packet :
+// count, first event time (uint32 micros), then for each event
+// type, data (3 bytes for encoders and TM1638 buttons, 2 for the others), time offset (uint16, 4us units).
+class SHInputEvents {
+private:
+	SHInputEvent events[INPUTEVENTS_MAX];
+	uint8_t count = 0;
+	bool batched = false;
+
+	static uint8_t dataLength(uint8_t type) {
+		return (type == INPUTEVENT_ENCODER || type == INPUTEVENT_ENCODERDELTA || type == INPUTEVENT_TM1638BUTTON) ? 3 : 2;
+	}
+
+	void sendBatch() {
+		uint8_t length = 5;
+		for (uint8_t i = 0; i < count; i++) {
+			length += 3 + dataLength(events[i].type);
+		}
+
+		unsigned long baseTime = events[0].time;
+
+		arqserial.CustomPacketStart(INPUTEVENT_BATCH, length);
+		arqserial.CustomPacketSendByte(count);
+		for (uint8_t b = 0; b < 4; b++) {
+			arqserial.CustomPacketSendByte((uint8_t)(baseTime >> (b * 8)));
+		}
+
+		for (uint8_t i = 0; i < count; i++) {
+			SHInputEvent & e = events[i];
+			unsigned long offset = (e.time - baseTime) >> 2;
+			if (offset > 0xFFFF)
+				offset = 0xFFFF;
+
+			arqserial.CustomPacketSendByte(e.type);
+			for (uint8_t d = 0; d < dataLength(e.type); d++) {
+				arqserial.CustomPacketSendByte(e.data[d]);
+			}
+			arqserial.CustomPacketSendByte((uint8_t)offset);
+			arqserial.CustomPacketSendByte((uint8_t)(offset >> 8));
+		}
+		arqserial.CustomPacketEnd();
+	}
+
+	void sendSingle(SHInputEvent & e) {
+		arqserial.CustomPacketStart(e.type, dataLength(e.type));
+		for (uint8_t d = 0; d < dataLength(e.type); d++) {
+			arqserial.CustomPacketSendByte(e.data[d]);
+		}
+		arqserial.CustomPacketEnd();
+	}
+
+public:
+
+	void push(uint8_t type, uint8_t data0, uint8_t data1, uint8_t data2 = 0) {
+		// Full, sends what was collected so far
+		if (count == INPUTEVENTS_MAX) {
+			flush();
+		}
+
+		SHInputEvent & e = events[count++];
+		e.type = type;
+		e.data[0] = data0;
+		e.data[1] = data1;
+		e.data[2] = data2;
+		e.time = micros();
+	}
+
+	void flush() {
+		if (count == 0)
+			return;
+
+		if (batched) {
+			sendBatch();
+		}
+		else {
+			for (uint8_t i = 0; i < count; i++) {
+				sendSingle(events[i]);
+			}
+		}
+		count = 0;
+	}
+
+	// Sends the pending events, once the batch window elapsed when batched
+	void update() {
+		if (count > 0 && (!batched || micros() - events[0].time >= INPUTEVENTS_BATCH_US)) {
+			flush();
+		}
+	}
+
+	void setBatched(bool enabled) {
+		flush();
+		batched = enabled;
+	}
+};
+
+SHInputEvents inputEvents;
+
+#endif
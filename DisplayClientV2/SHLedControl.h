@@ -25,7 +25,15 @@
 #else
 #include <WProgram.h>
 #endif
+#include <SPI.h>
+#include "SHFastIO.h"
 
+/*
+ * DATAPIN	pin on the Arduino where data gets shifted out
+ * CLKPIN	pin for the clock
+ * CSPIN	pin for selecting the device
+ */
+template <uint8_t DATAPIN, uint8_t CLKPIN, uint8_t CSPIN>
 class SHLedControl {
 private:
 	/* The array for shifting the data to the devices */
@@ -34,14 +42,32 @@ private:
 
 	/* We keep track of the led-status for all 8 devices in this array */
 	byte status[64];
-	/* Data is shifted out of this pin*/
-	int SPI_MOSI;
-	/* The clock is signaled on this pin */
-	int SPI_CLK;
-	/* This one is driven LOW for chip selectzion */
-	int SPI_CS;
 	/* The maximum number of devices we use */
 	int maxDevices;
+	/* Data and clock are on the hardware SPI pins */
+	static bool hardwareSPI() { return DATAPIN == MOSI && CLKPIN == SCK; }
+	/* Rows changed by setRowBuffered and not sent yet */
+	byte dirtyRows;
+
+	void sendChain(int maxbytes) {
+		//enable the line
+		FastPin<CSPIN>::low();
+		//Now shift out the data
+		if (hardwareSPI()) {
+			// MAX7219 supports up to 10MHz
+			SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+			for (int i = maxbytes; i > 0; i--)
+				SPI.transfer(spidata[i - 1]);
+			SPI.endTransaction();
+		}
+		else {
+			for (int i = maxbytes; i > 0; i--)
+				fastShiftOut<DATAPIN, CLKPIN>(MSBFIRST, spidata[i - 1]);
+		}
+		//latch the data onto the display
+		FastPin<CSPIN>::high();
+	}
+
 	void spiTransfer(int addr, volatile byte opcode, volatile byte data) {
 		//Create an array with the data to shift out
 		int offset = addr * 2;
@@ -52,35 +78,34 @@ private:
 		//put our device data into the array
 		spidata[offset + 1] = opcode;
 		spidata[offset] = data;
-		//enable the line
-		o_digitalWrite(SPI_CS, LOW);
-		//Now shift out the data
-		for (int i = maxbytes; i > 0; i--)
-			o_shiftOut(SPI_MOSI, SPI_CLK, MSBFIRST, spidata[i - 1]);
-		//latch the data onto the display
-		o_digitalWrite(SPI_CS, HIGH);
+		sendChain(maxbytes);
+	}
+
+	/* Sends the same row of every device in a single chain transfer */
+	void rowTransfer(int row) {
+		for (int addr = 0; addr < maxDevices; addr++) {
+			spidata[addr * 2 + 1] = row + 1;
+			spidata[addr * 2] = status[addr * 8 + row];
+		}
+		sendChain(maxDevices * 2);
 	}
 public:
 	/*
 	 * Create a new controler
 	 * Params :
-	 * dataPin		pin on the Arduino where data gets shifted out
-	 * clockPin		pin for the clock
-	 * csPin		pin for selecting the device
 	 * numDevices	maximum number of devices that can be controled
 	 */
-	void begin(int dataPin, int clkPin, int csPin, int numDevices) {
-		SPI_MOSI = dataPin;
-		SPI_CLK = clkPin;
-		SPI_CS = csPin;
+	void begin(int numDevices) {
 		if (numDevices <= 0 || numDevices > 8)
 			numDevices = 8;
 		maxDevices = numDevices;
-		pinMode(SPI_MOSI, OUTPUT);
-		pinMode(SPI_CLK, OUTPUT);
-		pinMode(SPI_CS, OUTPUT);
-		o_digitalWrite(SPI_CS, HIGH);
-		SPI_MOSI = dataPin;
+		dirtyRows = 0;
+		if (hardwareSPI())
+			SPI.begin();
+		FastPin<DATAPIN>::mode(OUTPUT);
+		FastPin<CLKPIN>::mode(OUTPUT);
+		FastPin<CSPIN>::mode(OUTPUT);
+		FastPin<CSPIN>::high();
 		for (int i = 0; i < 64; i++)
 			status[i] = 0x00;
 		for (int i = 0; i < maxDevices; i++) {
@@ -193,6 +218,38 @@ public:
 		spiTransfer(addr, row + 1, status[offset + row]);
 	}
 
+	/*
+	 * Set all 8 Led's in a row to a new state, without sending it.
+	 * Rows are sent by flushRows, only when their value changed.
+	 * Params:
+	 * addr	address of the display
+	 * row	row which is to be set (0..7)
+	 * value	each bit set to 1 will light up the
+	 *		corresponding Led.
+	 */
+	void setRowBuffered(int addr, int row, byte value) {
+		if (addr < 0 || addr >= maxDevices)
+			return;
+		if (row < 0 || row>7)
+			return;
+		if (status[addr * 8 + row] != value) {
+			status[addr * 8 + row] = value;
+			dirtyRows |= (1 << row);
+		}
+	}
+
+	/*
+	 * Send the rows changed by setRowBuffered, each changed row is written
+	 * to all the devices in a single chain transfer (8 transfers max).
+	 */
+	void flushRows() {
+		for (int row = 0; row < 8; row++) {
+			if (dirtyRows & (1 << row))
+				rowTransfer(row);
+		}
+		dirtyRows = 0;
+	}
+
 	/*
 	 * Set all 8 Led's in a column to a new state
 	 * Params:
@@ -215,21 +272,6 @@ public:
 		}
 	}
 
-	void o_digitalWrite(uint8_t pin, uint8_t val) {
-		uint8_t bit = digitalPinToBitMask(pin);
-		uint8_t port = digitalPinToPort(pin);
-		volatile uint8_t *out;
-
-		out = portOutputRegister(port);
-
-		if (val == LOW) {
-			*out &= ~bit;
-		}
-		else {
-			*out |= bit;
-		}
-	}
-
 	void shutdown(int addr, bool b) {
 		if (addr < 0 || addr >= maxDevices)
 			return;
@@ -238,21 +280,6 @@ public:
 		else
 			spiTransfer(addr, OP_SHUTDOWN, 1);
 	}
-
-	void o_shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
-	{
-		uint8_t i;
-
-		for (i = 0; i < 8; i++) {
-			if (bitOrder == LSBFIRST)
-				o_digitalWrite(dataPin, !!(val & (1 << i)));
-			else
-				o_digitalWrite(dataPin, !!(val & (1 << (7 - i))));
-
-			o_digitalWrite(clockPin, HIGH);
-			o_digitalWrite(clockPin, LOW);
-		}
-	}
 };
 
 #endif	//LedControl.h
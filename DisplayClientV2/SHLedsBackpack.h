@@ -1,11 +1,14 @@
 #ifdef INCLUDE_LEDBACKPACK
-void ADA7SEG_SetDisplayFromSerial(int idx)
+#include "SHHT16K33.h"
+
+// Display RAM contents are unknown until the first write
+bool ADA7SEG_Written = false;
+
+// 4 digits, position 2 is the colon, only queued when the display RAM changed
+void ADA7SEG_SetDigits(const byte * displayValues)
 {
-	byte displayValues[] = { 1, 2, 4, 8, 16, 32, 64, 128 };
-	// Digits
-	for (int i = 0; i < 8; i++) {
-		displayValues[i] = (char)FlowSerialTimedRead();
-	}
+	uint16_t previous[8];
+	memcpy(previous, ADA_HT16K33_7SEGMENTS.displaybuffer, sizeof(previous));
 
 	for (int i = 0; i < 2; i++) {
 		ADA_HT16K33_7SEGMENTS.writeDigitRaw(i, displayValues[i]);
@@ -17,24 +20,39 @@ void ADA7SEG_SetDisplayFromSerial(int idx)
 		ADA_HT16K33_7SEGMENTS.writeDigitRaw(i + 1, displayValues[i]);
 	}
 
-	ADA_HT16K33_7SEGMENTS.writeDisplay();
+	if (ADA7SEG_Written && memcmp(previous, ADA_HT16K33_7SEGMENTS.displaybuffer, sizeof(previous)) == 0)
+		return;
+
+	ADA7SEG_Written = true;
+	HT16K33_QueueDisplay(ADA_HT16K33_7SEGMENTS_I2CADDRESS, ADA_HT16K33_7SEGMENTS.displaybuffer);
+}
+
+void ADA7SEG_SetDisplayFromSerial(int idx)
+{
+	byte displayValues[] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+	// Digits
+	for (int i = 0; i < 8; i++) {
+		displayValues[i] = (char)FlowSerialTimedRead();
+	}
+
+	ADA7SEG_SetDigits(displayValues);
 }
 
 void ADA_HT16K33BICOLOR_Matrix_Read() {
 	int luminosity = FlowSerialTimedRead();
 
 	if (ADA_HT16K33_Matrix_luminosity != luminosity) {
-		ADA_HT16K33_MATRIX.setBrightness(luminosity);
+		HT16K33_QueueBrightness(ADA_HT16K33_BICOLORMATRIX_I2CADDRESS, luminosity);
 		ADA_HT16K33_Matrix_luminosity = luminosity;
 	}
 
+	byte rows[8];
 	for (int j = 0; j < 8; j++) {
-		byte row = FlowSerialTimedRead();
-		for (int c = 0; c < 8; c++) {
-			ADA_HT16K33_MATRIX.drawPixel(j, c, ((row & (1 << (8 - c - 1))) > 0) ? LED_ON : LED_OFF);
-		}
+		rows[j] = FlowSerialTimedRead();
 	}
 
-	ADA_HT16K33_MATRIX.writeDisplay();
+	if (HT16K33_SetFrame(ADA_HT16K33_MATRIX.displaybuffer, rows, true)) {
+		HT16K33_QueueDisplay(ADA_HT16K33_BICOLORMATRIX_I2CADDRESS, ADA_HT16K33_MATRIX.displaybuffer);
+	}
 }
 #endif
\ No newline at end of file
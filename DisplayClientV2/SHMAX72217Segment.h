@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include "SHLedControl.h"
 
+template <uint8_t DATAPIN, uint8_t CLKPIN, uint8_t LOADPIN>
 class SHMAX72217Segment {
 
 private:
@@ -14,12 +15,12 @@ private:
 		return (x >> 1) | ((x & 1) << 7);
 	}
 	int luminosity[6]{-1,-1,-1,-1,-1,-1};
-	SHLedControl MAX7221;
+	SHLedControl<DATAPIN, CLKPIN, LOADPIN> MAX7221;
 public:
 
 
-	void begin(int screens, int DataPin, int ClkPin, int LoadPin) {
-		MAX7221.begin(DataPin, ClkPin, LoadPin, screens);
+	void begin(int screens) {
+		MAX7221.begin(screens);
 		for (int i = 0; i < screens; i++) {
 			MAX7221.shutdown(i, false);
 			MAX7221.setIntensity(i, 15);
@@ -37,10 +38,27 @@ public:
 				luminosity[j] = newIntensity;
 			}
 			for (int i = 0; i < 8; i++) {
-				MAX7221.setRow(j, 7 - i, MAX7221_ByteReorder((char)FlowSerialTimedRead()));
+				MAX7221.setRowBuffered(j, 7 - i, MAX7221_ByteReorder((char)FlowSerialTimedRead()));
 			}
 		}
 
+		MAX7221.flushRows();
+
+	}
+
+	int getDeviceCount() {
+		return MAX7221.getDeviceCount();
+	}
+
+	// Digits only (leftmost first), sent with the next flushDigits
+	void setDigits(int device, const byte * digits) {
+		for (int i = 0; i < 8; i++) {
+			MAX7221.setRowBuffered(device, 7 - i, MAX7221_ByteReorder(digits[i]));
+		}
+	}
+
+	void flushDigits() {
+		MAX7221.flushRows();
 	}
 
 };
@@ -2,15 +2,19 @@
 #define __SHMatrixHT16H33SingleColor_H__
 #include <Arduino.h>
 #include "Adafruit_LEDBackpack.h"
+#include "SHHT16K33.h"
 
 class SHMatrixHT16H33SingleColor {
 private:
 
 	Adafruit_8x8matrix ADA_HT16K33_SINGLECOLOR_MATRIX = Adafruit_8x8matrix();
-	byte luminosity = 0;
+	// Brightness set by begin()
+	byte luminosity = 15;
+	uint8_t address;
 public:
 
 	void begin(int I2CAddress) {
+		address = I2CAddress;
 		ADA_HT16K33_SINGLECOLOR_MATRIX.begin(I2CAddress);
 		ADA_HT16K33_SINGLECOLOR_MATRIX.clear();
 		ADA_HT16K33_SINGLECOLOR_MATRIX.writeDisplay();
@@ -21,18 +25,18 @@ public:
 		// Wait for display data
 		int newIntensity = FlowSerialTimedRead();
 		if (newIntensity != luminosity) {
-			ADA_HT16K33_SINGLECOLOR_MATRIX.setBrightness(luminosity);
 			luminosity = newIntensity;
+			HT16K33_QueueBrightness(address, luminosity);
 		}
 
+		byte rows[8];
 		for (int j = 0; j < 8; j++) {
-			byte row = FlowSerialTimedRead();
-			for (int c = 0; c < 8; c++) {
-				ADA_HT16K33_SINGLECOLOR_MATRIX.drawPixel(j, c, ((row & (1 << (8 - c - 1))) > 0) ? LED_ON : LED_OFF);
-			}
+			rows[j] = FlowSerialTimedRead();
 		}
 
-		ADA_HT16K33_SINGLECOLOR_MATRIX.writeDisplay();
+		if (HT16K33_SetFrame(ADA_HT16K33_SINGLECOLOR_MATRIX.displaybuffer, rows, false)) {
+			HT16K33_QueueDisplay(address, ADA_HT16K33_SINGLECOLOR_MATRIX.displaybuffer);
+		}
 	}
 };
 #endif
\ No newline at end of file
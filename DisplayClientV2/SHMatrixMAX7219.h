@@ -3,15 +3,16 @@
 #include <Arduino.h>
 #include "SHLedControl.h"
 
+template <uint8_t DATAPIN, uint8_t CLKPIN, uint8_t LOADPIN>
 class SHMatrixMAX7219 {
 private:
 
-	SHLedControl  MAX7221;
+	SHLedControl<DATAPIN, CLKPIN, LOADPIN> MAX7221;
 	byte MAX7221_MATRIX_LUMINOSITY = 0;
 public:
 
-	void begin(int DataPin, int ClkPin, int LoadPin) {
-		MAX7221.begin(DataPin, ClkPin, LoadPin, 1);
+	void begin() {
+		MAX7221.begin(1);
 		MAX7221.shutdown(0, false);
 		MAX7221.setIntensity(0, 0);
 		MAX7221.clearDisplay(0);
@@ -27,8 +28,10 @@ public:
 		}
 
 		for (int j = 0; j < 8; j++) {
-			MAX7221.setRow(0, 7 - j, FlowSerialTimedRead());
+			MAX7221.setRowBuffered(0, 7 - j, FlowSerialTimedRead());
 		}
+
+		MAX7221.flushRows();
 	}
 };
 #endif
\ No newline at end of file
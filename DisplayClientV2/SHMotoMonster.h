@@ -4,16 +4,34 @@
 #define SH_BRAKEGND 3
 #define SH_CS_THRESHOLD 100
 
+#include "SHFastIO.h"
+
 /*  VNH2SP30 pin definitions
  xxx[0] controls '1' outputs
  xxx[1] controls '2' outputs */
-int SHMM_inApin[2] = { 7, 4 };  // INA: Clockwise input
-int SHMM_inBpin[2] = { 8, 9 }; // INB: Counter-clockwise input
+#define SHMM_INA0 7 // INA: Clockwise input
+#define SHMM_INA1 4
+#define SHMM_INB0 8 // INB: Counter-clockwise input
+#define SHMM_INB1 9
 int SHMM_pwmpin[2] = { 5, 6 }; // PWM input
 int SHMM_cspin[2] = { 2, 3 }; // CS: Current sense ANALOG input
 int SHMM_enpin[2] = { 0, 1 }; // EN: Status of switches output (Analog pin)
 
-int SHMM_statpin = 13;
+#define SHMM_STATPIN 13
+
+void SHMM_writeInA(uint8_t motor, bool value) {
+	if (motor == 0)
+		FastPin<SHMM_INA0>::write(value);
+	else
+		FastPin<SHMM_INA1>::write(value);
+}
+
+void SHMM_writeInB(uint8_t motor, bool value) {
+	if (motor == 0)
+		FastPin<SHMM_INB0>::write(value);
+	else
+		FastPin<SHMM_INB1>::write(value);
+}
 
 
 // pwmMode - sets the PWM frequency, valid options as follows:
@@ -27,12 +45,16 @@ int pwmMode = 0;        // value of 0, 1, 2 or 3 - modes 2 and 3 will overheat a
 
 void setupSHMotoMonster()
 {
-	pinMode(SHMM_statpin, OUTPUT);
+	FastPin<SHMM_STATPIN>::mode(OUTPUT);
+	FastPin<SHMM_INA0>::mode(OUTPUT);
+	FastPin<SHMM_INA1>::mode(OUTPUT);
+	FastPin<SHMM_INB0>::mode(OUTPUT);
+	FastPin<SHMM_INB1>::mode(OUTPUT);
 	// Initialize braked
 	for (int i = 0; i < 2; i++)
 	{
-		digitalWrite(SHMM_inApin[i], LOW);
-		digitalWrite(SHMM_inBpin[i], LOW);
+		SHMM_writeInA(i, LOW);
+		SHMM_writeInB(i, LOW);
 	}
 
 	// disable timer0's interrupt handler - this will disable Arduino's time keeping functions such as delay()
@@ -69,8 +91,8 @@ void setupSHMotoMonster()
 void SHMM_motorOff(int motor)
 {
 
-	digitalWrite(SHMM_inApin[motor], LOW);
-	digitalWrite(SHMM_inBpin[motor], LOW);
+	SHMM_writeInA(motor, LOW);
+	SHMM_writeInB(motor, LOW);
 	analogWrite(SHMM_pwmpin[motor], 0);
 }
 
@@ -97,16 +119,10 @@ void SHMM_motorGo(uint8_t motor, uint8_t direct, uint8_t pwm)
 		if (direct <= 4)
 		{
 			// Set inA[motor]
-			if (direct <= 1)
-				digitalWrite(SHMM_inApin[motor], HIGH);
-			else
-				digitalWrite(SHMM_inApin[motor], LOW);
+			SHMM_writeInA(motor, direct <= 1);
 
 			// Set inB[motor]
-			if ((direct == 0) || (direct == 2))
-				digitalWrite(SHMM_inBpin[motor], HIGH);
-			else
-				digitalWrite(SHMM_inBpin[motor], LOW);
+			SHMM_writeInB(motor, (direct == 0) || (direct == 2));
 
 			analogWrite(SHMM_pwmpin[motor], pwm);
 		}
@@ -0,0 +1,112 @@
+#ifndef __SHPORTDEBOUNCER_H__
+#define __SHPORTDEBOUNCER_H__
+
+#include <Arduino.h>
+
+// Time between two samples
+#ifndef DEBOUNCE_SAMPLE_US
+#define DEBOUNCE_SAMPLE_US 1000
+#endif
+
+// Identical samples needed before a change is accepted (1-8),
+// a change is seen after DEBOUNCE_SAMPLES to DEBOUNCE_SAMPLES + 1 sample periods
+#ifndef DEBOUNCE_SAMPLES
+#define DEBOUNCE_SAMPLES 4
+#endif
+
+#if DEBOUNCE_SAMPLES < 1 || DEBOUNCE_SAMPLES > 8
+#error "DEBOUNCE_SAMPLES must be between 1 and 8"
+#endif
+
+#define DEBOUNCER_MAXPORTS 6
+#define DEBOUNCER_NOPIN 0xFF
+
+// Debounces the digital inputs a whole port at a time : each port keeps its last samples
+// as bytes (shift register per bit), an input changes when all its samples agree.
+class SHPortDebouncer {
+private:
+	struct DebouncedPort {
+		uint8_t port;
+		uint8_t mask;
+		uint8_t state;
+		uint8_t history[DEBOUNCE_SAMPLES];
+	};
+
+	DebouncedPort ports[DEBOUNCER_MAXPORTS];
+	uint8_t portsCount = 0;
+	unsigned long lastSample;
+
+	void sample(DebouncedPort & p) {
+		uint8_t value = *portInputRegister(p.port) & p.mask;
+
+		uint8_t allHigh = value;
+		uint8_t anyHigh = value;
+		for (uint8_t i = DEBOUNCE_SAMPLES - 1; i > 0; i--) {
+			p.history[i] = p.history[i - 1];
+			allHigh &= p.history[i];
+			anyHigh |= p.history[i];
+		}
+		p.history[0] = value;
+
+		// Stable bits take the sampled level, the others keep their state
+		p.state = allHigh | (p.state & anyHigh);
+	}
+
+public:
+
+	// Returns the input id, DEBOUNCER_NOPIN when no more ports are available.
+	// The pin must already be configured as an input.
+	uint8_t addPin(uint8_t pin) {
+		uint8_t port = digitalPinToPort(pin);
+		uint8_t bit = digitalPinToBitMask(pin);
+		uint8_t slot = 0;
+
+		while (slot < portsCount && ports[slot].port != port)
+			slot++;
+
+		if (slot == DEBOUNCER_MAXPORTS)
+			return DEBOUNCER_NOPIN;
+
+		if (slot == portsCount) {
+			ports[slot].port = port;
+			ports[slot].mask = 0;
+			ports[slot].state = 0;
+			memset(ports[slot].history, 0, DEBOUNCE_SAMPLES);
+			portsCount++;
+		}
+
+		// Starts from the current level
+		DebouncedPort & p = ports[slot];
+		uint8_t level = *portInputRegister(port) & bit;
+		p.mask |= bit;
+		p.state = (p.state & ~bit) | level;
+		for (uint8_t i = 0; i < DEBOUNCE_SAMPLES; i++) {
+			p.history[i] = (p.history[i] & ~bit) | level;
+		}
+
+		uint8_t bitIndex = 0;
+		while (!(bit & (1 << bitIndex)))
+			bitIndex++;
+		return (slot << 3) | bitIndex;
+	}
+
+	// Samples every port when the sample period elapsed
+	void update() {
+		unsigned long now = micros();
+		if (now - lastSample < DEBOUNCE_SAMPLE_US)
+			return;
+		lastSample = now;
+
+		for (uint8_t i = 0; i < portsCount; i++) {
+			sample(ports[i]);
+		}
+	}
+
+	int digitalRead(uint8_t id) {
+		return (ports[id >> 3].state & (1 << (id & 7))) ? HIGH : LOW;
+	}
+};
+
+SHPortDebouncer inputsDebouncer;
+
+#endif
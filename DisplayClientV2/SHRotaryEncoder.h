@@ -3,7 +3,7 @@
 
 #include <Arduino.h>
 #include "SHFastIO.h"
-#include "SHDebouncer.h"
+#include "SHPortDebouncer.h"
 
 #define R_START	   0x0
 #define DIR_CW    0x10
@@ -48,52 +48,236 @@ static const unsigned char halfStepsTable[][4] =
 };
 
 typedef void(*SHRotaryEncoderPositionChanged) (int, int, byte);
+// Encoder id, accelerated delta since the previous report (positive with the position), position
+typedef void(*SHRotaryEncoderDeltaChanged) (int, int, int);
+
+// Pin change interrupt decoding, can be disabled before including this file
+#ifndef ENCODERS_ENABLE_INTERRUPTS
+#define ENCODERS_ENABLE_INTERRUPTS 1
+#endif
+
+#if ENCODERS_ENABLE_INTERRUPTS == 1 && defined(PCICR)
+#define ENCODERS_USE_PCINT
+#endif
+
+// Pin change vector bit of a pin, usable in #if when the pin is a number
+#define ENCODERS_PCINT_VECTOR(pin) _BV(digitalPinToPCICRbit(pin))
+
+// Pin change vectors defined here (bit n for PCINTn_vect), the others are left to other libraries.
+// Encoders on a vector which isn't in the list are polled.
+#ifndef ENCODERS_PCINT_VECTORS
+#define ENCODERS_PCINT_VECTORS 0x07
+#endif
+
+// Steps queue size, must be a power of 2
+#ifndef ENCODERS_QUEUESIZE
+#define ENCODERS_QUEUESIZE 32
+#endif
+
+#define ENCODERS_MAXINTERRUPTED 8
+#define ENCODER_EVENT_CW 0x80
+
+// Acceleration : detents closer than ENCODERS_ACCEL_SLOW_MS count for more than one step,
+// up to ENCODERS_ACCEL_MAX steps at ENCODERS_ACCEL_FAST_MS. Reversing starts again from one step.
+#ifndef ENCODERS_ACCEL_SLOW_MS
+#define ENCODERS_ACCEL_SLOW_MS 40
+#endif
+
+#ifndef ENCODERS_ACCEL_FAST_MS
+#define ENCODERS_ACCEL_FAST_MS 5
+#endif
+
+#ifndef ENCODERS_ACCEL_MAX
+#define ENCODERS_ACCEL_MAX 8
+#endif
+
+// Minimum time between two delta reports of an encoder
+#ifndef ENCODERS_REPORT_MS
+#define ENCODERS_REPORT_MS 20
+#endif
+
+struct SHEncoderEvent {
+	uint8_t step;
+	uint16_t time;
+};
+
+// Steps decoded by the pin change interrupts (single producer) and consumed by the main loop (single consumer).
+// Each index is only written by one side, byte accesses are atomic so no locking is needed.
+class SHEncoderEventQueue {
+private:
+	// Volatile as well so the event is written before head is published
+	volatile SHEncoderEvent events[ENCODERS_QUEUESIZE];
+	volatile uint8_t head = 0;
+	volatile uint8_t tail = 0;
+
+public:
+	bool push(uint8_t step, uint16_t time) {
+		uint8_t next = (head + 1) & (ENCODERS_QUEUESIZE - 1);
+		if (next == tail)
+			return false;
+		events[head].step = step;
+		events[head].time = time;
+		head = next;
+		return true;
+	}
+
+	bool pop(SHEncoderEvent & event) {
+		if (tail == head)
+			return false;
+		event.step = events[tail].step;
+		event.time = events[tail].time;
+		tail = (tail + 1) & (ENCODERS_QUEUESIZE - 1);
+		return true;
+	}
+};
+
+// Accelerated deltas instead of one report per detent, enabled by the host
+bool encodersReportDeltas = false;
+SHRotaryEncoderDeltaChanged encodersDeltaCallback = 0;
 
 class SHRotaryEncoder {
 private:
 
 	FastDigitalPin outputA; // CLK
 	FastDigitalPin outputB; // DT
-	FastDigitalPin button;
+	uint8_t buttonInput = DEBOUNCER_NOPIN;
 
 	int counter = 0;
 	bool halfSteps = false;
 
 	uint8_t inputLastState;
-	uint8_t buttonState;
 
-	int buttonLastState;
-	unsigned long lastbuttonchange;
+	int buttonLastState = HIGH;
 	unsigned long positionLastChanged;
 	unsigned long directionLastChange = 255;
-	SHDebouncer buttonDebouncer;
 	uint8_t direction;
 
 	byte id;
 	SHRotaryEncoderPositionChanged positionChangedCallback;
 
+	// Decoded by the pin change interrupts instead of read()
+	bool interruptDriven = false;
+
+	// Steps which didn't fit in the queue, positive clockwise
+	volatile int8_t overflowSteps = 0;
+
+	// Acceleration state, detent times in milliseconds (16 bits)
+	uint16_t lastStepTime = 0;
+	uint8_t lastStepDirection = 0;
+	int pendingDelta = 0;
+	unsigned long lastDeltaReport;
+
+	// Returns DIR_CW, DIR_CCW or 0, interrupt safe
+	uint8_t decode() {
+		if (!halfSteps)
+			inputLastState = fullStepsTable[inputLastState & 0xf][(outputB.digitalRead() << 1) | outputA.digitalRead()];
+		else {
+			inputLastState = halfStepsTable[inputLastState & 0xf][(outputB.digitalRead() << 1) | outputA.digitalRead()];
+		}
+
+		return inputLastState & 0x30;
+	}
+
+	uint8_t acceleration(uint8_t stepDirection, uint16_t time) {
+		uint16_t interval = time - lastStepTime;
+		bool reversed = stepDirection != lastStepDirection;
+		lastStepTime = time;
+		lastStepDirection = stepDirection;
+
+		if (reversed || interval >= ENCODERS_ACCEL_SLOW_MS)
+			return 1;
+		if (interval <= ENCODERS_ACCEL_FAST_MS)
+			return ENCODERS_ACCEL_MAX;
+		return 1 + (ENCODERS_ACCEL_SLOW_MS - interval) * (ENCODERS_ACCEL_MAX - 1) / (ENCODERS_ACCEL_SLOW_MS - ENCODERS_ACCEL_FAST_MS);
+	}
+
+	// time : when the detent was decoded (millis)
+	void applyStep(uint8_t stepDirection, uint16_t time) {
+		direction = stepDirection;
+		if (direction != DIR_CCW && direction != DIR_CW)
+			return;
+
+		uint8_t steps = acceleration(direction, time);
+
+		if (direction == DIR_CCW) {
+			counter++;
+			pendingDelta += steps;
+			if (!encodersReportDeltas)
+				positionChangedCallback(id, counter, 0);
+			directionLastChange = 0;
+		}
+		else {
+			counter--;
+			pendingDelta -= steps;
+			if (!encodersReportDeltas)
+				positionChangedCallback(id, counter, 1);
+			directionLastChange = 1;
+		}
+		positionLastChanged = millis();
+
+		if (!encodersReportDeltas)
+			pendingDelta = 0;
+	}
+
+	// Sends the steps summed since the previous report, a first detent after a pause is sent at once
+	void reportDelta() {
+		if (pendingDelta == 0 || !encodersDeltaCallback)
+			return;
+
+		unsigned long now = millis();
+		if (now - lastDeltaReport < ENCODERS_REPORT_MS)
+			return;
+
+		int delta = constrain(pendingDelta, -127, 127);
+		encodersDeltaCallback(id, delta, counter);
+		pendingDelta -= delta;
+		lastDeltaReport = now;
+	}
+
+#ifdef ENCODERS_USE_PCINT
+	static bool hasPinChange(uint8_t pin) {
+		return digitalPinToPCICR(pin) != 0 && (ENCODERS_PCINT_VECTORS & ENCODERS_PCINT_VECTOR(pin));
+	}
+
+	static void enablePinChange(uint8_t pin) {
+		*digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+		*digitalPinToPCICR(pin) |= _BV(digitalPinToPCICRbit(pin));
+	}
+#endif
+
+	friend void SHRotaryEncoder_Interrupt();
+	friend void SHRotaryEncoder_ProcessEvents();
+
 public:
 
 	void begin(uint8_t outputAPin, uint8_t outputBPin, int buttonPin, bool reverse, bool enablePullup, byte encoderid, bool half, SHRotaryEncoderPositionChanged changedcallback) {
 		halfSteps = half;
-		buttonDebouncer.begin(50);
 		outputA.begin((!reverse) ? outputAPin : outputBPin);
 		outputB.begin((!reverse) ? outputBPin : outputAPin);
 
 		pinMode(outputAPin, enablePullup ? INPUT_PULLUP : INPUT);
 		pinMode(outputBPin, enablePullup ? INPUT_PULLUP : INPUT);
 
-		button.begin(buttonPin);
 		if (buttonPin > 0) {
 			pinMode(buttonPin, enablePullup ? INPUT_PULLUP : INPUT);
 		}
+		if (buttonPin >= 0) {
+			buttonInput = inputsDebouncer.addPin(buttonPin);
+		}
 
 		id = encoderid;
 		inputLastState = 0;
-		buttonLastState = button.digitalRead();
+		if (buttonInput != DEBOUNCER_NOPIN) {
+			buttonLastState = inputsDebouncer.digitalRead(buttonInput);
+		}
 		positionChangedCallback = changedcallback;
+
+		attachInterrupts(outputAPin, outputBPin);
 	}
 
+	// Switches to interrupt decoding when both outputs have a pin change interrupt, otherwise read() keeps polling
+	void attachInterrupts(uint8_t outputAPin, uint8_t outputBPin);
+
 	uint8_t getDirection(uint8_t delay, unsigned long referenceTime) {
 		if (directionLastChange != 255 && (referenceTime - positionLastChanged) < delay) {
 			return directionLastChange;
@@ -106,37 +290,103 @@ public:
 	}
 
 	void read() {
-		if (!halfSteps)
-			inputLastState = fullStepsTable[inputLastState & 0xf][(outputB.digitalRead() << 1) | outputA.digitalRead()];
-		else {
-			inputLastState = halfStepsTable[inputLastState & 0xf][(outputB.digitalRead() << 1) | outputA.digitalRead()];
+		if (!interruptDriven) {
+			applyStep(decode(), millis());
 		}
 
-		direction = (inputLastState & 0x30);
-
-		if (direction == DIR_CCW) {
-			counter++;
-			positionChangedCallback(id, counter, 0);
-			positionLastChanged = millis();
-			directionLastChange = 0;
-		}
-		else if (direction == DIR_CW) {
-			counter--;
-			positionChangedCallback(id, counter, 1);
-			positionLastChanged = millis();
-			directionLastChange = 1;
+		if (encodersReportDeltas) {
+			reportDelta();
 		}
 
-		if (button.isValid()) {
-			buttonState = button.digitalRead();
+		// Debounced by inputsDebouncer
+		if (buttonInput != DEBOUNCER_NOPIN) {
+			int buttonState = inputsDebouncer.digitalRead(buttonInput);
 			if (buttonState != buttonLastState) {
-				if (buttonDebouncer.Debounce()) {
-					positionChangedCallback(id, counter, buttonState == HIGH ? 2 : 3);
-					buttonLastState = buttonState;
-				}
+				positionChangedCallback(id, counter, buttonState == HIGH ? 2 : 3);
+				buttonLastState = buttonState;
 			}
 		}
 	}
 };
 
+SHEncoderEventQueue encoderEvents;
+SHRotaryEncoder * interruptedEncoders[ENCODERS_MAXINTERRUPTED];
+volatile uint8_t interruptedEncodersCount = 0;
+
+void SHRotaryEncoder::attachInterrupts(uint8_t outputAPin, uint8_t outputBPin) {
+#ifdef ENCODERS_USE_PCINT
+	if (interruptedEncodersCount >= ENCODERS_MAXINTERRUPTED || !hasPinChange(outputAPin) || !hasPinChange(outputBPin))
+		return;
+
+	// Initial state, then registered before the interrupts are enabled
+	decode();
+	interruptDriven = true;
+	interruptedEncoders[interruptedEncodersCount] = this;
+	interruptedEncodersCount++;
+
+	enablePinChange(outputAPin);
+	enablePinChange(outputBPin);
+#endif
+}
+
+// Decodes every interrupt driven encoder, the state tables ignore unchanged inputs
+void SHRotaryEncoder_Interrupt() {
+	for (uint8_t i = 0; i < interruptedEncodersCount; i++) {
+		SHRotaryEncoder * encoder = interruptedEncoders[i];
+		uint8_t stepDirection = encoder->decode();
+		if (stepDirection == 0)
+			continue;
+
+		if (!encoderEvents.push(i | (stepDirection == DIR_CW ? ENCODER_EVENT_CW : 0), millis())) {
+			int8_t steps = encoder->overflowSteps;
+			if (stepDirection == DIR_CW ? steps < 127 : steps > -127)
+				encoder->overflowSteps = steps + (stepDirection == DIR_CW ? 1 : -1);
+		}
+	}
+}
+
+// Sends the steps decoded by the interrupts, to be called from the main loop
+void SHRotaryEncoder_ProcessEvents() {
+	SHEncoderEvent event;
+	while (encoderEvents.pop(event)) {
+		interruptedEncoders[event.step & 0x7F]->applyStep((event.step & ENCODER_EVENT_CW) ? DIR_CW : DIR_CCW, event.time);
+	}
+
+	for (uint8_t i = 0; i < interruptedEncodersCount; i++) {
+		SHRotaryEncoder * encoder = interruptedEncoders[i];
+		if (encoder->overflowSteps == 0)
+			continue;
+
+		noInterrupts();
+		int8_t steps = encoder->overflowSteps;
+		encoder->overflowSteps = 0;
+		interrupts();
+
+		// Their decode times are lost, replayed as slow detents (no acceleration)
+		uint16_t time = encoder->lastStepTime;
+		for (; steps > 0; steps--)
+			encoder->applyStep(DIR_CW, time += ENCODERS_ACCEL_SLOW_MS);
+		for (; steps < 0; steps++)
+			encoder->applyStep(DIR_CCW, time += ENCODERS_ACCEL_SLOW_MS);
+	}
+}
+
+#ifdef ENCODERS_USE_PCINT
+#if defined(PCINT0_vect) && (ENCODERS_PCINT_VECTORS & 0x01)
+ISR(PCINT0_vect) {
+	SHRotaryEncoder_Interrupt();
+}
+#endif
+#if defined(PCINT1_vect) && (ENCODERS_PCINT_VECTORS & 0x02)
+ISR(PCINT1_vect) {
+	SHRotaryEncoder_Interrupt();
+}
+#endif
+#if defined(PCINT2_vect) && (ENCODERS_PCINT_VECTORS & 0x04)
+ISR(PCINT2_vect) {
+	SHRotaryEncoder_Interrupt();
+}
+#endif
+#endif
+
 #endif
\ No newline at end of file
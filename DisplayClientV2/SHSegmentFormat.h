@@ -0,0 +1,117 @@
+#ifndef __SHSEGMENTFORMAT_H__
+#define __SHSEGMENTFORMAT_H__
+
+#include <Arduino.h>
+
+// Formatted values rendered on the device for the 7 segments displays.
+// Segments use the same layout as the raw host frames : bit 0 = A ... bit 6 = G, bit 7 = DP.
+
+// Format byte : low nibble format, high nibble decimal places (fixed point only)
+#define SEGFMT_INT 0
+#define SEGFMT_FIXED 1
+#define SEGFMT_TIME 2
+#define SEGFMT_GEAR 3
+
+// Module left unchanged, no value follows
+#define SEGFMT_KEEP 0xFF
+
+#define SEGFMT_DP 0x80
+#define SEGFMT_MINUS 0x40
+#define SEGFMT_BLANK 0x00
+#define SEGFMT_REVERSE 0x50 // r
+#define SEGFMT_NEUTRAL 0x54 // n
+
+const uint8_t SEGFMT_FONT[10] PROGMEM = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F };
+
+uint8_t SegmentFormat_Digit(uint8_t n) {
+	return pgm_read_byte(SEGFMT_FONT + n);
+}
+
+// Writes n right aligned ending at position pos, with at least minDigits digits.
+// Returns the position left of the number, or -2 when it doesn't fit.
+int SegmentFormat_Number(uint8_t * digits, int pos, uint16_t n, uint8_t minDigits) {
+	uint8_t count = 0;
+	do {
+		if (pos < 0)
+			return -2;
+		digits[pos--] = SegmentFormat_Digit(n % 10);
+		n /= 10;
+		count++;
+	} while (n > 0 || count < minDigits);
+	return pos;
+}
+
+// Renders value over count digits (leftmost first) :
+// int : -123, fixed : value / 10^decimals (1234 with 2 decimals : 12.34),
+// time : tenths of seconds (unsigned) as m.ss.t, gear : -1 r, 0 n, 1-9 on the rightmost digit.
+// Values that don't fit show dashes.
+void SegmentFormat(uint8_t format, int16_t value, uint8_t * digits, uint8_t count) {
+	uint8_t type = format & 0x0F;
+	uint8_t decimals = format >> 4;
+	int pos = count - 1;
+
+	memset(digits, SEGFMT_BLANK, count);
+
+	if (type == SEGFMT_GEAR) {
+		if (value < 0)
+			digits[pos] = SEGFMT_REVERSE;
+		else if (value == 0)
+			digits[pos] = SEGFMT_NEUTRAL;
+		else if (value < 10)
+			digits[pos] = SegmentFormat_Digit(value);
+		else
+			digits[pos] = SEGFMT_MINUS;
+		return;
+	}
+
+	if (type == SEGFMT_TIME) {
+		uint16_t tenths = (uint16_t)value;
+		if (count >= 4) {
+			digits[pos--] = SegmentFormat_Digit(tenths % 10);
+			pos = SegmentFormat_Number(digits, pos, (tenths / 10) % 60, 2);
+			pos = SegmentFormat_Number(digits, pos, tenths / 600, 1);
+			if (pos >= -1) {
+				digits[count - 2] |= SEGFMT_DP;
+				digits[count - 4] |= SEGFMT_DP;
+				return;
+			}
+		}
+	}
+	else {
+		bool negative = value < 0;
+		uint16_t n = negative ? -(int32_t)value : value;
+
+		if (type != SEGFMT_FIXED)
+			decimals = 0;
+
+		pos = SegmentFormat_Number(digits, pos, n, decimals + 1);
+		if (pos >= -1) {
+			if (decimals > 0)
+				digits[count - 1 - decimals] |= SEGFMT_DP;
+			if (!negative)
+				return;
+			if (pos >= 0) {
+				digits[pos] = SEGFMT_MINUS;
+				return;
+			}
+		}
+	}
+
+	memset(digits, SEGFMT_MINUS, count);
+}
+
+// Reads a module format, then its value (int16, little endian) unless the format is SEGFMT_KEEP.
+// Returns false when the module is kept.
+bool SegmentFormat_Read(uint8_t * digits, uint8_t count) {
+	uint8_t format = FlowSerialTimedRead();
+	if (format == SEGFMT_KEEP)
+		return false;
+
+	int16_t value = FlowSerialTimedRead();
+	value |= FlowSerialTimedRead() << 8;
+
+	SegmentFormat(format, value, digits, count);
+	return true;
+}
+
+#endif
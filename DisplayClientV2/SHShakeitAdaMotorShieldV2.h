@@ -5,15 +5,34 @@
 #include "SHShakeitBase.h"
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_MS_PWMServoDriver.h"
+#include "SHI2CQueue.h"
+
+// PCA9685 first channel register, 4 registers per channel
+#define ADAMOTORS_LED0_ON_L 0x06
+// Register + 3 channels of 4 registers
+#define ADAMOTORS_WRITE_LENGTH 13
 
 class SHShakeitAdaMotorShieldV2 : public SHShakeitBase {
 private:
 	Adafruit_MotorShield Shield1; // Default address, no jumpers
 	Adafruit_MotorShield Shield2; // Rightmost jumper closed
 	Adafruit_MotorShield Shield3; // Rightmost jumper closed
-	Adafruit_DCMotor * AdaMotors[12];
 	byte boardsCount = 0;
 
+	// Last value sent to each motor, the PCA9685 outputs are off after begin
+	uint8_t outputs[12] = { 0 };
+
+	// PCA9685 channels used by each motor as in Adafruit_MotorShield::getMotor : pwm, in2, in1.
+	// The 3 channels of a motor are contiguous and written in a single transaction.
+	const uint8_t motorPins[4][3] = { { 8, 9, 10 }, { 13, 12, 11 }, { 2, 3, 4 }, { 7, 6, 5 } };
+
+	void queueChannel(uint16_t on, uint16_t off) {
+		i2cQueue.write((uint8_t)(on & 0xFF));
+		i2cQueue.write((uint8_t)(on >> 8));
+		i2cQueue.write((uint8_t)(off & 0xFF));
+		i2cQueue.write((uint8_t)(off >> 8));
+	}
+
 public:
 	uint8_t motorCount() {
 		return boardsCount * 4;
@@ -32,43 +51,52 @@ public:
 			// Default address, no jumpers
 			Shield1 = Adafruit_MotorShield(0x60);
 			Shield1.begin(frequency);
-			AdaMotors[0] = Shield1.getMotor(1);
-			AdaMotors[1] = Shield1.getMotor(2);
-			AdaMotors[2] = Shield1.getMotor(3);
-			AdaMotors[3] = Shield1.getMotor(4);
 		}
 
 		if (boardsCount >= 2) {
 			// Rightmost jumper closed
 			Shield2 = Adafruit_MotorShield(0x61);
 			Shield2.begin(frequency);
-			AdaMotors[4] = Shield2.getMotor(1);
-			AdaMotors[5] = Shield2.getMotor(2);
-			AdaMotors[6] = Shield2.getMotor(3);
-			AdaMotors[7] = Shield2.getMotor(4);
 		}
 
 		if (boardsCount >= 3) {
 			// Rightmost jumper closed
 			Shield3 = Adafruit_MotorShield(0x62);
 			Shield3.begin(frequency);
-			AdaMotors[8] = Shield3.getMotor(1);
-			AdaMotors[9] = Shield3.getMotor(2);
-			AdaMotors[10] = Shield3.getMotor(3);
-			AdaMotors[11] = Shield3.getMotor(4);
 		}
 	}
 
 protected:
+	// Same outputs as run(FORWARD) + setSpeed(value) or run(RELEASE), queued ahead of display updates
 	void setMotorOutput(uint8_t motorIdx, uint8_t value) {
-		if (value == 0) {
-			AdaMotors[motorIdx]->run(RELEASE);
-		}
-		else {
-			AdaMotors[motorIdx]->run(FORWARD);
-			AdaMotors[motorIdx]->setSpeed(value);
+		if (outputs[motorIdx] == value)
+			return;
+		outputs[motorIdx] = value;
+
+		const uint8_t * pins = motorPins[motorIdx % 4];
+		uint8_t firstChannel = min(pins[0], pins[2]);
+
+		i2cQueue.beginWrite(I2CQUEUE_PRIORITY_HIGH, 0x60 + motorIdx / 4, ADAMOTORS_WRITE_LENGTH, true);
+		i2cQueue.write((uint8_t)(ADAMOTORS_LED0_ON_L + 4 * firstChannel));
+
+		for (uint8_t channel = firstChannel; channel < firstChannel + 3; channel++) {
+			if (channel == pins[0]) {
+				queueChannel(0, value * 16);
+			}
+			else if (channel == pins[2] && value > 0) {
+				// Full on
+				queueChannel(4096, 0);
+			}
+			else {
+				queueChannel(0, 0);
+			}
 		}
 	}
+
+	// Effects don't wait for the queue, they are written on a later tick
+	bool outputReady() {
+		return i2cQueue.canWrite(I2CQUEUE_PRIORITY_HIGH, ADAMOTORS_WRITE_LENGTH);
+	}
 };
 
 #endif
\ No newline at end of file
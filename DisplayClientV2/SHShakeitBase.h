@@ -3,9 +3,19 @@
 
 #include <Arduino.h>
 #define SHShakeitBaseSafetyDelay 1000
+#define SHAKEIT_MAXMOTORS 12
+
+// Each motor output is the host intensity plus the on device effects level (SHHaptics), saturated
 class SHShakeitBase {
 private:
 	unsigned long lastRead = 0;
+	uint8_t hostLevels[SHAKEIT_MAXMOTORS] = { 0 };
+	uint8_t effectLevels[SHAKEIT_MAXMOTORS] = { 0 };
+
+	void applyOutput(uint8_t motorIdx) {
+		uint16_t value = hostLevels[motorIdx] + effectLevels[motorIdx];
+		setMotorOutput(motorIdx, value > 255 ? 255 : value);
+	}
 
 public:
 	virtual uint8_t motorCount();
@@ -15,6 +25,8 @@ public:
 		if (millis() - lastRead > SHShakeitBaseSafetyDelay && lastRead > 0) {
 			uint8_t motorcount = motorCount();
 			for (int m = 0; m < motorcount; m++) {
+				hostLevels[m] = 0;
+				effectLevels[m] = 0;
 				setMotorOutput(m, 0);
 			}
 			lastRead = 0;
@@ -27,7 +39,10 @@ public:
 		for (int motorIdx = 0; motorIdx < motorcount; motorIdx++) {
 			int value = FlowSerialTimedRead();
 			if (value != -1) {
-				setMotorOutput(motorIdx, value);
+				if (motorIdx < SHAKEIT_MAXMOTORS) {
+					hostLevels[motorIdx] = value;
+					applyOutput(motorIdx);
+				}
 			}
 			else {
 				return;
@@ -36,8 +51,20 @@ public:
 		lastRead = millis();
 	}
 
+	// Skipped when the output can't be written without waiting, the level is applied on a later call
+	void setEffectLevel(uint8_t motorIdx, uint8_t level) {
+		if (motorIdx >= SHAKEIT_MAXMOTORS || effectLevels[motorIdx] == level || !outputReady())
+			return;
+		effectLevels[motorIdx] = level;
+		applyOutput(motorIdx);
+	}
+
 protected:
 	virtual void setMotorOutput(uint8_t motorIdx, uint8_t value);
+
+	virtual bool outputReady() {
+		return true;
+	}
 };
 
 #endif
\ No newline at end of file
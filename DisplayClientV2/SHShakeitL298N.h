@@ -3,15 +3,10 @@
 
 #include <Arduino.h>
 #include "SHShakeitBase.h"
+#include "SHFastIO.h"
 
+template <uint8_t ENA, uint8_t ENB, uint8_t IN1, uint8_t IN2, uint8_t IN3, uint8_t IN4>
 class SHShakeitL298N : public SHShakeitBase {
-private:
-	byte	pinL98N_enA;
-	byte	pinL98N_enB;
-	byte	pinL98N_in1;
-	byte	pinL98N_in2;
-	byte	pinL98N_in3;
-	byte	pinL98N_in4;
 public:
 	uint8_t motorCount() {
 		return 2;
@@ -21,51 +16,44 @@ public:
 		return "L298N";
 	}
 
-	void begin(byte	pL98N_enA, byte	pL98N_enB, byte	pL98N_in1, byte	pL98N_in2, byte	pL98N_in3, byte	pL98N_in4) {
+	void begin() {
+		FastPin<ENA>::mode(OUTPUT);
+		FastPin<ENB>::mode(OUTPUT);
+		FastPin<IN1>::mode(OUTPUT);
+		FastPin<IN2>::mode(OUTPUT);
+		FastPin<IN3>::mode(OUTPUT);
+		FastPin<IN4>::mode(OUTPUT);
 
-		pinL98N_enA = pL98N_enA;
-		pinL98N_enB = pL98N_enB;
-		pinL98N_in1 = pL98N_in1;
-		pinL98N_in2 = pL98N_in2;
-		pinL98N_in3 = pL98N_in3;
-		pinL98N_in4 = pL98N_in4;
+		FastPin<ENA>::low();
+		FastPin<ENB>::low();
 
-		pinMode(pinL98N_enA, OUTPUT);
-		pinMode(pinL98N_enB, OUTPUT);
-		pinMode(pinL98N_in1, OUTPUT);
-		pinMode(pinL98N_in2, OUTPUT);
-		pinMode(pinL98N_in3, OUTPUT);
-		pinMode(pinL98N_in4, OUTPUT);
+		FastPin<IN1>::low();
+		FastPin<IN2>::high();
 
-		digitalWrite(pinL98N_enA, LOW);
-		digitalWrite(pinL98N_enB, LOW);
-
-		digitalWrite(pinL98N_in1, LOW);
-		digitalWrite(pinL98N_in2, HIGH);
-
-		digitalWrite(pinL98N_in3, LOW);
-		digitalWrite(pinL98N_in4, HIGH);
+		FastPin<IN3>::low();
+		FastPin<IN4>::high();
 	}
 
 protected:
 	void setMotorOutput(uint8_t motorIdx, uint8_t value) {
+		// PWM outputs still go through analogWrite, it drives the timer
 		if (motorIdx == 0) {
 			if (value == 0) {
-				digitalWrite(pinL98N_enA, LOW);
+				digitalWrite(ENA, LOW);
 			}
 			else {
-				analogWrite(pinL98N_enA, value);
+				analogWrite(ENA, value);
 			}
 		}
 		else {
 			if (value == 0) {
-				digitalWrite(pinL98N_enB, LOW);
+				digitalWrite(ENB, LOW);
 			}
 			else {
-				analogWrite(pinL98N_enB, value);
+				analogWrite(ENB, value);
 			}
 		}
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,26 +1,90 @@
 #include "TM1637.h"
 
-TM1637 TM1637_module1(TM1637_CLK1, TM1637_DIO1);
-TM1637 TM1637_module2(TM1637_CLK2, TM1637_DIO2);
-TM1637 TM1637_module3(TM1637_CLK3, TM1637_DIO3);
-TM1637 TM1637_module4(TM1637_CLK4, TM1637_DIO4);
-TM1637 TM1637_module5(TM1637_CLK5, TM1637_DIO5);
-TM1637 TM1637_module6(TM1637_CLK6, TM1637_DIO6);
-TM1637 TM1637_module7(TM1637_CLK7, TM1637_DIO7);
-TM1637 TM1637_module8(TM1637_CLK8, TM1637_DIO8);
-
-TM1637 * TM1637_screens[] = { &TM1637_module1, &TM1637_module2, &TM1637_module3, &TM1637_module4, &TM1637_module5, &TM1637_module6, &TM1637_module7, &TM1637_module8 };
-
-void TM1637_SetDisplayFromSerial(TM1637 * screen)
+// TM1637 keeping the last written digits and brightness,
+// a frame is written with a single auto address burst and only when it changed
+class SHTM1637 : public TM1637 {
+private:
+	byte digits[4];
+	int brightness = -1;
+
+public:
+	SHTM1637(uint8_t clk, uint8_t dio) : TM1637(clk, dio) {
+	}
+
+	void writeFrame(byte newBrightness, const byte * newDigits) {
+		if (newBrightness == brightness && memcmp(newDigits, digits, 4) == 0)
+			return;
+
+		brightness = newBrightness;
+		memcpy(digits, newDigits, 4);
+		set(newBrightness);
+
+		start();
+		writeByte(ADDR_AUTO);
+		stop();
+		start();
+		writeByte(STARTADDR);
+		for (int i = 0; i < 4; i++) {
+			writeByte(digits[i]);
+		}
+		stop();
+		start();
+		writeByte(Cmd_DispCtrl);
+		stop();
+	}
+
+	// Digits only, keeps the last brightness
+	void writeDigits(const byte * newDigits) {
+		writeFrame(brightness < 0 ? BRIGHT_TYPICAL : brightness, newDigits);
+	}
+};
+
+SHTM1637 TM1637_module1(TM1637_CLK1, TM1637_DIO1);
+SHTM1637 TM1637_module2(TM1637_CLK2, TM1637_DIO2);
+SHTM1637 TM1637_module3(TM1637_CLK3, TM1637_DIO3);
+SHTM1637 TM1637_module4(TM1637_CLK4, TM1637_DIO4);
+SHTM1637 TM1637_module5(TM1637_CLK5, TM1637_DIO5);
+SHTM1637 TM1637_module6(TM1637_CLK6, TM1637_DIO6);
+SHTM1637 TM1637_module7(TM1637_CLK7, TM1637_DIO7);
+SHTM1637 TM1637_module8(TM1637_CLK8, TM1637_DIO8);
+
+SHTM1637 * TM1637_screens[] = { &TM1637_module1, &TM1637_module2, &TM1637_module3, &TM1637_module4, &TM1637_module5, &TM1637_module6, &TM1637_module7, &TM1637_module8 };
+
+void TM1637_SetDisplayFromSerial(SHTM1637 * screen, byte brightness)
 {
+	byte digits[4];
 	for (int i = 0; i < 4; i++) {
-		screen->rawDisplay(i, FlowSerialTimedRead());
+		digits[i] = FlowSerialTimedRead();
 	}
 
 	// Skip 4 remaining chars
 	for (int i = 0; i < 4; i++) {
 		FlowSerialTimedRead();
 	}
+
+	screen->writeFrame(brightness, digits);
+}
+
+// Compact frame : changed modules mask (bit 0 : 1st module), then for each module in the mask
+// brightness and 4 digits. Modules not in the mask keep their contents.
+void TM1637_ReadCompactFrame()
+{
+	byte mask = FlowSerialTimedRead();
+	byte digits[4];
+
+	for (int j = 0; j < 8; j++) {
+		if (!(mask & (1 << j)))
+			continue;
+
+		byte brightness = FlowSerialTimedRead();
+		for (int i = 0; i < 4; i++) {
+			digits[i] = FlowSerialTimedRead();
+		}
+
+		if (j < TM1637_ENABLEDMODULES) {
+			TM1637_screens[j]->writeFrame(brightness, digits);
+		}
+	}
 }
 
 void TM1637_Init() {
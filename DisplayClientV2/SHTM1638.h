@@ -1,9 +1,123 @@
 #include <TM1638.h>
+#include "SHFastIO.h"
+
+#ifdef INCLUDE_TM1638
+// TM1638 keeping a copy of its display RAM (even addresses : digits, odd addresses : leds),
+// only the changed address range is sent, as a single auto increment burst.
+// The display writes and button reads are bit-banged on the common TM1638_DIO/TM1638_CLK pins,
+// the library is only used for the setup.
+class SHTM1638 : public TM1638 {
+private:
+	byte ram[16];
+	FastDigitalPin strobe;
+
+	// Clock pulses of at least 400ns
+	static void clockDelay() {
+		delayMicroseconds(1);
+	}
+
+	// LSB first, clock idles high
+	static void sendByte(byte data) {
+		for (byte i = 0; i < 8; i++) {
+			FastPin<TM1638_CLK>::low();
+			FastPin<TM1638_DIO>::write(data & 1);
+			data >>= 1;
+			clockDelay();
+			FastPin<TM1638_CLK>::high();
+			clockDelay();
+		}
+	}
+
+	static byte receiveByte() {
+		byte data = 0;
+		for (byte i = 0; i < 8; i++) {
+			data >>= 1;
+			FastPin<TM1638_CLK>::low();
+			clockDelay();
+			if (FastPin<TM1638_DIO>::read())
+				data |= 0x80;
+			FastPin<TM1638_CLK>::high();
+			clockDelay();
+		}
+		return data;
+	}
+
+public:
+	SHTM1638(byte dataPin, byte clockPin, byte strobePin, boolean activateDisplay) : TM1638(dataPin, clockPin, strobePin, activateDisplay) {
+		// The display RAM is cleared by the TM16XX constructor
+		resetShadow();
+		strobe.begin(strobePin);
+	}
+
+	// Same as TM1638::getButtons
+	byte getButtons() {
+		byte keys = 0;
+
+		strobe.digitalWrite(LOW);
+		sendByte(0x42);
+		FastPin<TM1638_DIO>::mode(INPUT_PULLUP);
+		clockDelay();
+		for (byte i = 0; i < 4; i++) {
+			keys |= receiveByte() << i;
+		}
+		FastPin<TM1638_DIO>::mode(OUTPUT);
+		FastPin<TM1638_DIO>::low();
+		strobe.digitalWrite(HIGH);
+
+		return keys;
+	}
+
+	// To be called after clearDisplay
+	void resetShadow() {
+		memset(ram, 0, sizeof(ram));
+	}
+
+	void writeChanged(const byte * data) {
+		int first = -1;
+		int last = -1;
+
+		for (byte i = 0; i < 16; i++) {
+			if (data[i] != ram[i]) {
+				if (first < 0)
+					first = i;
+				last = i;
+				ram[i] = data[i];
+			}
+		}
+
+		if (first < 0)
+			return;
+
+		// Data write, auto increment
+		strobe.digitalWrite(LOW);
+		sendByte(0x40);
+		strobe.digitalWrite(HIGH);
+		clockDelay();
+
+		strobe.digitalWrite(LOW);
+		sendByte(0xC0 | first);
+		for (int i = first; i <= last; i++) {
+			sendByte(ram[i]);
+		}
+		strobe.digitalWrite(HIGH);
+	}
+
+	// Digits only, keeps the leds
+	void writeDigits(const byte * digits) {
+		byte data[16];
+		memcpy(data, ram, sizeof(data));
+		for (byte i = 0; i < 8; i++) {
+			data[i << 1] = digits[i];
+		}
+		writeChanged(data);
+	}
+};
+#endif
 
 struct ScreenItem {
 public:
 #ifdef INCLUDE_TM1638
-	TM1638 * Screen;
+	SHTM1638 * Screen;
 #endif
 	byte Buttons;
 	byte Oldbuttons;
@@ -11,7 +125,7 @@ public:
 
 	ScreenItem() { }
 #ifdef INCLUDE_TM1638
-	ScreenItem(TM1638 * module) : Screen(module) {
+	ScreenItem(SHTM1638 * module) : Screen(module) {
 		this->Buttons = 0;
 		this->Oldbuttons = 0;
 		this->Intensity = 7;
@@ -20,22 +134,22 @@ public:
 };
 
 #ifdef INCLUDE_TM1638
-TM1638 TM1638_module1(TM1638_DIO, TM1638_CLK, TM1638_STB1, false);
+SHTM1638 TM1638_module1(TM1638_DIO, TM1638_CLK, TM1638_STB1, false);
 ScreenItem TM1638_screen1(&TM1638_module1);
 
-TM1638 TM1638_module2(TM1638_DIO, TM1638_CLK, TM1638_STB2, false);
+SHTM1638 TM1638_module2(TM1638_DIO, TM1638_CLK, TM1638_STB2, false);
 ScreenItem TM1638_screen2(&TM1638_module2);
 
-TM1638 TM1638_module3(TM1638_DIO, TM1638_CLK, TM1638_STB3, false);
+SHTM1638 TM1638_module3(TM1638_DIO, TM1638_CLK, TM1638_STB3, false);
 ScreenItem TM1638_screen3(&TM1638_module3);
 
-TM1638 TM1638_module4(TM1638_DIO, TM1638_CLK, TM1638_STB4, false);
+SHTM1638 TM1638_module4(TM1638_DIO, TM1638_CLK, TM1638_STB4, false);
 ScreenItem TM1638_screen4(&TM1638_module4);
 
-TM1638 TM1638_module5(TM1638_DIO, TM1638_CLK, TM1638_STB5, false);
+SHTM1638 TM1638_module5(TM1638_DIO, TM1638_CLK, TM1638_STB5, false);
 ScreenItem TM1638_screen5(&TM1638_module5);
 
-TM1638 TM1638_module6(TM1638_DIO, TM1638_CLK, TM1638_STB6, false);
+SHTM1638 TM1638_module6(TM1638_DIO, TM1638_CLK, TM1638_STB6, false);
 ScreenItem TM1638_screen6(&TM1638_module6);
 
 // Screen referencing
@@ -46,18 +160,17 @@ void TM1638_Init() {
 	{
 		TM1638_screens[i]->Screen->setupDisplay(true, 7);
 		TM1638_screens[i]->Screen->clearDisplay();
+		TM1638_screens[i]->Screen->resetShadow();
 	}
 }
 
-void TM1638_SetDisplayFromSerial(TM1638 * screen)
+void TM1638_SetDisplayFromSerial(SHTM1638 * screen)
 {
-	byte displayValues[] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+	byte ram[16];
 	for (int i = 0; i < 8; i++) {
-		displayValues[i] = FlowSerialTimedRead();
+		ram[i << 1] = FlowSerialTimedRead();
 	}
 
-	screen->setDisplay(displayValues);
-
 	for (int i = 0; i < 8; i++) {
 		char state = (char)FlowSerialTimedRead();
 
@@ -74,18 +187,20 @@ void TM1638_SetDisplayFromSerial(TM1638 * screen)
 		}
 
 		if (state == 'G') {
-			screen->setLED(TM1638_COLOR_GREEN, i);
+			ram[(i << 1) + 1] = TM1638_COLOR_GREEN;
 		}
 		else if (state == 'R') {
-			screen->setLED(TM1638_COLOR_RED, i);
+			ram[(i << 1) + 1] = TM1638_COLOR_RED;
 		}
 		else if (state == 'Y') {
-			screen->setLED(TM1638_COLOR_RED + TM1638_COLOR_GREEN, i);
+			ram[(i << 1) + 1] = TM1638_COLOR_RED + TM1638_COLOR_GREEN;
 		}
 		else {
-			screen->setLED(TM1638_COLOR_NONE, i);
+			ram[(i << 1) + 1] = TM1638_COLOR_NONE;
 		}
 	}
+
+	screen->writeChanged(ram);
 }
 
 #endif